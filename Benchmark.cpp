@@ -0,0 +1,283 @@
+//Timing sweeps over the engines, kept apart from the correctness fuzzing in Test.cpp
+//Prints a row (CSV) or object (JSON, with --json) per engine per workload to stdout
+//Built with ISLANDS_STATS=1, each also carries the counters from the engine's last timed run
+//count_islands goes by the default thresholds; by ones loaded with --thresholds=FILE; or with
+//--calibrate, by ones measured first, and saved with --calibrate=FILE for later runs to load
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Islands.hpp"
+#include "Generate.hpp"
+
+namespace bench
+{
+    typedef std::chrono::steady_clock clock;
+
+    struct options
+    {
+        std::size_t warmups{ 2 }, reps{ 9 };
+        std::uint64_t seed{ generate::default_seed }; //Fixed, so runs on different builds time the same grids
+        bool json{ false }, quick{ false }, calibrate{ false };
+        std::string thresholds, calibrated; //Files to load thresholds from, and to save calibrated ones to
+    };
+
+    struct engine_t
+    {
+        char const *const txt;
+        std::size_t(*func)(islands::matrix<bool const *> const &);
+    } const engines[]{
+        {"solve", &islands::solve},
+        {"solve2", &islands::solve2},
+        {"solve2_tiled", [](islands::matrix<bool const *> const &input) { return islands::solve2_tiled(input); }},
+        {"solve3", &islands::solve3},
+        {"solve4", &islands::solve4},
+        {"count_islands", [](islands::matrix<bool const *> const &input) { return islands::count_islands(input); }},
+    };
+
+    enum class layout { row_major, transposed };
+    char const *const layout_names[]{ "row_major", "transposed" };
+
+    //Independent cells, blobs of radius 4, or terrain smoothed over 4 cells
+    enum class pattern { bernoulli, clustered, correlated };
+    char const *const pattern_names[]{ "bernoulli", "clustered", "correlated" };
+
+    struct workload
+    {
+        std::size_t width, height;
+        double density;
+        pattern shape;
+        layout order;
+    };
+
+    typedef std::chrono::nanoseconds::rep nanos;
+
+    //Nanoseconds per run, over the timed repetitions
+    struct summary
+    {
+        nanos min, p10, median, p90, max;
+    };
+
+    //Nearest-rank percentile of sorted samples
+    [[nodiscard]] nanos percentile(std::vector<nanos> const &sorted, double fraction)
+    {
+        auto const rank{ static_cast<std::size_t>(std::ceil(fraction * sorted.size())) };
+        return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    [[nodiscard]] summary time_engine(engine_t const &engine, islands::matrix<bool const *> const &input,
+        options const &opts, std::size_t &found, stats::counters &counts)
+    {
+        for (std::size_t count{ 0 }; count < opts.warmups; ++count)
+            found = (*engine.func)(input);
+        std::vector<nanos> samples;
+        samples.reserve(opts.reps);
+        for (std::size_t count{ 0 }; count < opts.reps; ++count)
+        {
+            if constexpr (stats::enabled)
+                (void)stats::collect();
+            auto const start{ clock::now() };
+            found = (*engine.func)(input);
+            samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+            if constexpr (stats::enabled)
+                counts = stats::collect();
+        }
+        std::sort(begin(samples), end(samples));
+        return { samples.front(), percentile(samples, 0.1), percentile(samples, 0.5),
+            percentile(samples, 0.9), samples.back() };
+    }
+
+    class report
+    {
+        std::ostream &dest;
+        bool const json;
+        bool first{ true };
+    public:
+        report(std::ostream &dest, bool json) : dest{ dest }, json{ json }
+        {
+            if (json)
+                dest << "[";
+            else
+                dest << "engine,width,height,density,pattern,layout,islands,reps,"
+                    "min_ns,p10_ns,median_ns,p90_ns,max_ns,median_ns_per_cell" <<
+                    (stats::enabled ? ",add_new,coalesce,coalesce_nocheck,unions,normalize_ns,merge_ns" : "") <<
+                    std::endl;
+        }
+        ~report(void) noexcept(false)
+        {
+            if (json)
+                dest << std::endl << "]" << std::endl;
+        }
+        void add(char const *engine, workload const &load, std::size_t found, std::size_t reps,
+            summary const &times, stats::counters const &counts)
+        {
+            auto const per_cell{
+                static_cast<double>(times.median) / std::max<std::size_t>(load.width * load.height, 1)
+            };
+            if (json)
+            {
+                dest << (std::exchange(first, false) ? "" : ",") << std::endl <<
+                    "  {\"engine\": \"" << engine << "\", \"width\": " << load.width <<
+                    ", \"height\": " << load.height << ", \"density\": " << load.density <<
+                    ", \"pattern\": \"" << pattern_names[static_cast<int>(load.shape)] <<
+                    "\", \"layout\": \"" << layout_names[static_cast<int>(load.order)] <<
+                    "\", \"islands\": " << found << ", \"reps\": " << reps <<
+                    ", \"min_ns\": " << times.min << ", \"p10_ns\": " << times.p10 <<
+                    ", \"median_ns\": " << times.median << ", \"p90_ns\": " << times.p90 <<
+                    ", \"max_ns\": " << times.max << ", \"median_ns_per_cell\": " << per_cell;
+                if constexpr (stats::enabled)
+                {
+                    dest << ", \"stats\": ";
+                    counts.write_json(dest);
+                }
+                dest << "}";
+            }
+            else
+            {
+                dest << engine << ',' << load.width << ',' << load.height << ',' << load.density << ',' <<
+                    pattern_names[static_cast<int>(load.shape)] << ',' << layout_names[static_cast<int>(load.order)] << ',' << found << ',' << reps << ',' <<
+                    times.min << ',' << times.p10 << ',' << times.median << ',' << times.p90 << ',' <<
+                    times.max << ',' << per_cell;
+                if constexpr (stats::enabled)
+                    dest << ',' << counts.add_new << ',' << counts.coalesce << ',' << counts.coalesce_nocheck <<
+                        ',' << counts.unions << ',' << counts.normalize.count() << ',' << counts.merge.count();
+                dest << std::endl;
+            }
+        }
+    };
+
+    [[nodiscard]] options parse(int argc, char *argv[])
+    {
+        options retval;
+        for (int index{ 1 }; index < argc; ++index)
+        {
+            std::string const arg{ argv[index] };
+            auto const value{ [&](char const *name) { return std::stoull(arg.substr(std::strlen(name))); } };
+            if ("--json" == arg)
+                retval.json = true;
+            else if ("--quick" == arg)
+                retval.quick = true;
+            else if ("--calibrate" == arg)
+                retval.calibrate = true;
+            else if (arg.starts_with("--calibrate="))
+                retval.calibrate = true, retval.calibrated = arg.substr(std::strlen("--calibrate="));
+            else if (arg.starts_with("--thresholds="))
+                retval.thresholds = arg.substr(std::strlen("--thresholds="));
+            else if (arg.starts_with("--reps="))
+                retval.reps = std::max<std::size_t>(value("--reps="), 1);
+            else if (arg.starts_with("--warmups="))
+                retval.warmups = value("--warmups=");
+            else if (arg.starts_with("--seed="))
+                retval.seed = value("--seed=");
+            else
+                throw std::invalid_argument("Usage: Benchmark [--json] [--quick] [--calibrate[=FILE] | "
+                    "--thresholds=FILE] [--reps=N] [--warmups=N] [--seed=N]; unknown argument " + arg);
+        }
+        if (retval.calibrate && !retval.thresholds.empty())
+            throw std::invalid_argument("--calibrate and --thresholds each set the thresholds; pass one");
+        return retval;
+    }
+}
+
+int _cdecl main(int argc, char *argv[])
+{
+    using namespace bench;
+    options opts;
+    try
+    {
+        opts = parse(argc, argv);
+    }
+    catch (std::exception const &error)
+    {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    //So count_islands dispatches by this machine's crossovers; they go to the file, if given, else stderr
+    try
+    {
+        if (!opts.thresholds.empty())
+            (void)islands::load_thresholds(opts.thresholds);
+        else if (opts.calibrate)
+        {
+            auto const limits{ islands::calibrate(opts.seed) };
+            if (opts.calibrated.empty())
+                limits.write(std::cerr);
+            else
+            {
+                std::ofstream dest(opts.calibrated);
+                limits.write(dest);
+                if (!dest.flush())
+                    throw std::runtime_error("Can't save dispatch thresholds to " + opts.calibrated);
+            }
+        }
+    }
+    catch (std::exception const &error)
+    {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    generate::engine rng(opts.seed);
+    //Cell counts, width:height ratios, and densities either side of 2D percolation's 0.5
+    std::vector<std::size_t> const sizes{ opts.quick ?
+        std::vector<std::size_t>{ 1 << 12, 1 << 16 } :
+        std::vector<std::size_t>{ 1 << 12, 1 << 16, 1 << 20, 1 << 22 } };
+    std::vector<double> const aspects{ opts.quick ?
+        std::vector<double>{ 1 } :
+        std::vector<double>{ 1, 4, 1. / 4, 64, 1. / 64 } };
+    std::vector<double> const densities{ opts.quick ?
+        std::vector<double>{ 0.5 } :
+        std::vector<double>{ 0.3, 0.45, 0.5, 0.55, 0.7 } };
+    std::vector<pattern> const patterns{ opts.quick ?
+        std::vector<pattern>{ pattern::bernoulli } :
+        std::vector<pattern>{ pattern::bernoulli, pattern::clustered, pattern::correlated } };
+    report out(std::cout, opts.json);
+    std::vector<char> cells, transposed;
+    for (auto const size : sizes)
+        for (auto const aspect : aspects)
+        {
+            auto const width{ std::max<std::size_t>(static_cast<std::size_t>(std::sqrt(size * aspect)), 1) };
+            auto const height{ std::max<std::size_t>(size / width, 1) };
+            cells.resize(width * height);
+            transposed.resize(width * height);
+            for (auto const density : densities)
+                for (auto const shape : patterns)
+                {
+                    std::span<bool> const grid{ reinterpret_cast<bool *>(cells.data()), cells.size() };
+                    if (pattern::bernoulli == shape)
+                        generate::bernoulli(grid, density, rng);
+                    else if (pattern::clustered == shape)
+                        generate::clustered(grid, width, density, 4, rng);
+                    else
+                        generate::correlated(grid, width, density, 4, rng);
+                    for (std::size_t index{ 0 }; index < height; ++index)
+                        for (std::size_t jndex{ 0 }; jndex < width; ++jndex)
+                            transposed[jndex * height + index] = cells[index * width + jndex];
+                    islands::matrix<bool const *> const inputs[]{
+                        { islands::matrix_slice(width, height), reinterpret_cast<bool const *>(cells.data()) },
+                        { lin_alg3::slice<2>{ 0, { { width, static_cast<std::ptrdiff_t>(height) }, { height, 1 } } },
+                            reinterpret_cast<bool const *>(transposed.data()) },
+                    };
+                    for (auto const order : { layout::row_major, layout::transposed })
+                        for (auto const &engine : engines)
+                        {
+                            std::size_t found;
+                            stats::counters counts;
+                            auto const times{
+                                time_engine(engine, inputs[static_cast<int>(order)], opts, found, counts)
+                            };
+                            out.add(engine.txt, { width, height, density, shape, order }, found, opts.reps,
+                                times, counts);
+                        }
+                }
+        }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "Islands.hpp"
+
+namespace generate
+{
+    //Same seed as the benchmark, so runs on different builds see the same grids
+    constexpr std::uint64_t const default_seed{ 20210525 };
+
+    //xoshiro256**: a full 64 random bits per call, several times faster than mt19937_64
+    class engine
+    {
+        std::uint64_t state[4];
+    public:
+        typedef std::uint64_t result_type;
+        explicit engine(std::uint64_t seed = default_seed) noexcept
+        {
+            //splitmix64, so even nearby seeds start far apart
+            for (auto &word : state)
+            {
+                auto mixed{ seed += 0x9E3779B97F4A7C15 };
+                mixed = (mixed ^ mixed >> 30) * 0xBF58476D1CE4E5B9;
+                mixed = (mixed ^ mixed >> 27) * 0x94D049BB133111EB;
+                word = mixed ^ mixed >> 31;
+            }
+        }
+        [[nodiscard]] static constexpr result_type min(void) noexcept { return 0; }
+        [[nodiscard]] static constexpr result_type max(void) noexcept
+        {
+            return std::numeric_limits<result_type>::max();
+        }
+        result_type operator()(void) noexcept
+        {
+            auto const retval{ std::rotl(state[1] * 5, 7) * 9 };
+            auto const shifted{ state[1] << 17 };
+            state[2] ^= state[0];
+            state[3] ^= state[1];
+            state[1] ^= state[2];
+            state[0] ^= state[3];
+            state[2] ^= shifted;
+            state[3] = std::rotl(state[3], 45);
+            return retval;
+        }
+    };
+
+    //Engines whose every call is 64 uniform bits, so each can be cut up into several cells' worth
+    template<typename urng_t>
+    concept word_source = std::uniform_random_bit_generator<urng_t> &&
+        0 == urng_t::min() && std::numeric_limits<std::uint64_t>::max() == urng_t::max();
+
+    namespace _internal
+    {
+        //p in 65536ths, the resolution of the threshold compares
+        [[nodiscard]] std::uint32_t threshold(double p) noexcept
+        {
+            return static_cast<std::uint32_t>(std::clamp(std::llround(p * 65536), 0LL, 65536LL));
+        }
+    }
+
+    //Independent cells, each land with probability p (to 1/65536): four cells to a random word, each
+    //land if its 16 bits fall under p's threshold
+    template<word_source urng_t>
+    void bernoulli(std::span<bool> cells, double p, urng_t &rng)
+    {
+        auto const cutoff{ _internal::threshold(p) };
+        auto const size{ cells.size() };
+        std::size_t index{ 0 };
+        for (; index + 4 <= size; index += 4)
+        {
+            auto const word{ rng() };
+            for (std::size_t lane{ 0 }; lane < 4; ++lane)
+                cells[index + lane] = (word >> 16 * lane & 0xFFFF) < cutoff;
+        }
+        if (index < size)
+            for (auto word{ rng() }; index < size; ++index, word >>= 16)
+                cells[index] = (word & 0xFFFF) < cutoff;
+    }
+
+    //Same, but a bit per cell, 64 cells at once: random words are folded together along p's binary
+    //expansion, least significant digit first, OR for a 1 and AND for a 0, which leaves each bit set
+    //with probability p; p = 1/2 costs one word, and no p more than 16
+    template<word_source urng_t>
+    void bernoulli(std::span<islands::packed_word> words, double p, urng_t &rng)
+    {
+        auto const cutoff{ _internal::threshold(p) };
+        if (!cutoff || 65536 == cutoff)
+        {
+            std::ranges::fill(words, cutoff ? ~islands::packed_word{ 0 } : 0);
+            return;
+        }
+        //ANDing into all 0s leaves all 0s, so the trailing 0 digits can be skipped
+        auto const first{ std::countr_zero(cutoff) };
+        for (auto &word : words)
+        {
+            islands::packed_word bits{ 0 };
+            for (auto digit{ first }; digit < 16; ++digit)
+                bits = cutoff >> digit & 1 ? bits | rng() : bits & rng();
+            word = bits;
+        }
+    }
+
+    //A packed grid (lsb_first, as islands::pack makes) of independent cells
+    template<word_source urng_t>
+    [[nodiscard]] auto bernoulli_packed(std::size_t width, std::size_t height, double p, urng_t &rng)
+    {
+        using islands::packed_word, islands::word_bits;
+        auto const stride{ islands::words_for(width) };
+        islands::packed_matrix<std::unique_ptr<packed_word[]>> retval{
+            width, height, static_cast<std::ptrdiff_t>(stride),
+            std::make_unique_for_overwrite<packed_word[]>(stride * height)
+        };
+        bernoulli(std::span{ retval.data.get(), stride * height }, p, rng);
+        //Keep the padding past each row's last cell clear
+        if (width % word_bits)
+            for (std::size_t index{ 1 }; index <= height; ++index)
+                retval.data[index * stride - 1] &= ~packed_word{ 0 } >> (word_bits - width % word_bits);
+        return retval;
+    }
+
+    //Blobs: land wherever one of a Poisson scatter of discs of the given radius lands, with enough
+    //discs on average to cover a fraction p of the grid (width wide, row-major)
+    //Centers fall within radius of the grid too, so the edges are as covered as the middle
+    template<word_source urng_t>
+    void clustered(std::span<bool> cells, std::size_t width, double p, double radius, urng_t &rng)
+    {
+        std::ranges::fill(cells, p >= 1);
+        if (p <= 0 || p >= 1 || !width)
+            return;
+        auto const height{ cells.size() / width };
+        radius = std::max(radius, 0.5);
+        //Coverage is 1 - exp(-density * area of a disc)
+        auto const density{ -std::log1p(-p) / (std::numbers::pi * radius * radius) };
+        std::poisson_distribution<std::size_t> count(density * (width + 2 * radius) * (height + 2 * radius));
+        std::uniform_real_distribution<double> across(-radius, width + radius), down(-radius, height + radius);
+        for (auto discs{ count(rng) }; discs--; )
+        {
+            auto const cx{ across(rng) }, cy{ down(rng) };
+            auto const top{ std::max(std::ceil(cy - radius - 0.5), 0.) },
+                bottom{ std::min(std::floor(cy + radius - 0.5), height - 1.) };
+            for (auto y{ top }; y <= bottom; ++y)
+            {
+                //Cell centers are at half-integers
+                auto const dy{ y + 0.5 - cy }, half{ std::sqrt(std::max(radius * radius - dy * dy, 0.)) };
+                auto const left{ std::max(std::ceil(cx - half - 0.5), 0.) },
+                    right{ std::min(std::floor(cx + half - 0.5), width - 1.) };
+                if (left <= right)
+                    std::fill(cells.begin() + static_cast<std::ptrdiff_t>(y * width + left),
+                        cells.begin() + static_cast<std::ptrdiff_t>(y * width + right + 1), true);
+            }
+        }
+    }
+
+    namespace _internal
+    {
+        //Moving average of each row over [x - radius, x + radius], clipped to the row
+        void blur_rows(std::span<float> field, std::size_t width, std::size_t radius, std::vector<float> &copy)
+        {
+            copy.resize(width);
+            for (auto row{ field.data() }, stop{ field.data() + field.size() }; row != stop; row += width)
+            {
+                std::copy_n(row, width, begin(copy));
+                double sum{ 0 };
+                std::size_t lo{ 0 }, hi{ 0 }; //Window is [lo, hi)
+                for (std::size_t index{ 0 }; index < width; ++index)
+                {
+                    for (; hi < width && hi <= index + radius; ++hi)
+                        sum += copy[hi];
+                    for (; lo + radius < index; ++lo)
+                        sum -= copy[lo];
+                    row[index] = static_cast<float>(sum / (hi - lo));
+                }
+            }
+        }
+        //Same down each column, but a row at a time, keeping every column's sum at once so the
+        //passes stay sequential in memory
+        void blur_columns(std::span<float> field, std::size_t width, std::size_t radius, std::vector<float> &copy)
+        {
+            auto const height{ field.size() / width };
+            copy.assign(begin(field), end(field));
+            std::vector<double> sums(width);
+            std::size_t lo{ 0 }, hi{ 0 }; //Window is rows [lo, hi)
+            for (std::size_t index{ 0 }; index < height; ++index)
+            {
+                for (; hi < height && hi <= index + radius; ++hi)
+                    for (std::size_t jndex{ 0 }; jndex < width; ++jndex)
+                        sums[jndex] += copy[hi * width + jndex];
+                for (; lo + radius < index; ++lo)
+                    for (std::size_t jndex{ 0 }; jndex < width; ++jndex)
+                        sums[jndex] -= copy[lo * width + jndex];
+                auto const rows{ static_cast<double>(hi - lo) };
+                for (std::size_t jndex{ 0 }; jndex < width; ++jndex)
+                    field[index * width + jndex] = static_cast<float>(sums[jndex] / rows);
+            }
+        }
+    }
+
+    //Smooth terrain: white noise blurred over about length cells (three box blurs each way, close to
+    //a Gaussian), then cut at whatever height leaves round(p * cells) of it land
+    template<word_source urng_t>
+    void correlated(std::span<bool> cells, std::size_t width, double p, double length, urng_t &rng)
+    {
+        if (!width || cells.empty())
+            return;
+        auto const height{ cells.size() / width }, size{ width * height };
+        std::vector<float> field(size), copy;
+        std::uniform_real_distribution<float> noise(-1, 1);
+        for (auto &value : field)
+            value = noise(rng);
+        //Three passes of radius r have a standard deviation of sqrt(r (r + 1)), about r
+        auto const radius{ static_cast<std::size_t>(std::max(std::lround(length), 0L)) };
+        for (int pass{ 0 }; pass < 3 && radius; ++pass)
+        {
+            _internal::blur_rows(field, width, radius, copy);
+            _internal::blur_columns(field, width, radius, copy);
+        }
+        auto const land{ static_cast<std::size_t>(std::clamp(std::llround(p * size), 0LL,
+            static_cast<long long>(size))) };
+        if (!land)
+        {
+            std::ranges::fill(cells, false);
+            return;
+        }
+        //Cut at the land-th highest value; cells tied with it fill in from the top left until the
+        //count comes out exact
+        copy.assign(begin(field), end(field));
+        std::nth_element(begin(copy), begin(copy) + static_cast<std::ptrdiff_t>(land - 1), end(copy),
+            std::greater<>{});
+        auto const cut{ copy[land - 1] };
+        auto ties{ land - static_cast<std::size_t>(std::ranges::count_if(field,
+            [cut](float value) { return value > cut; })) };
+        for (std::size_t index{ 0 }; index < size; ++index)
+            cells[index] = field[index] > cut || (field[index] == cut && ties && ties--);
+    }
+}
\ No newline at end of file
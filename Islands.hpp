@@ -1,9 +1,31 @@
 #pragma once
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <memory>
 #include <numeric>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "Tweaks.hpp"
 #include "LinAlg3.hpp"
+#include "Tasks.hpp"
 
 namespace islands
 {
@@ -20,107 +42,824 @@ namespace islands
         data_t data;
     };
 
+    //Which cells count as adjacent
+    enum class connectivity
+    {
+        four, //Left, right, up, down
+        eight, //Diagonals too
+        //Hexagonal lattice in "odd-r" layout: odd rows sit half a cell right of even rows, so each
+        //cell touches its left and right neighbors and two cells in each adjacent row
+        hex
+    };
+
     auto matrix_slice(std::size_t width, std::size_t height)
     {
         return lin_alg3::slice<2>{0, { {width, 1}, {height, static_cast<std::ptrdiff_t>(width)} }};
     }
 
+    //Bit-packed grid, row-major
+    //In lsb_first order, bit b of element e in a row is column e * digits + b; in msb_first order
+    //(as in PBM files) columns run from the most significant bit down
+    //Bits past the width are ignored
+    typedef std::uint64_t packed_word;
+    constexpr std::size_t const word_bits{ std::numeric_limits<packed_word>::digits };
+    enum class bit_order { lsb_first, msb_first };
+
+    template<typename data_t, bit_order order = bit_order::lsb_first>
+    struct packed_matrix
+    {
+        std::size_t width, height;
+        std::ptrdiff_t stride; //In elements (words or bytes), from one row to the next
+        data_t data;
+    };
+
+    [[nodiscard]] constexpr std::size_t words_for(std::size_t width) noexcept
+    {
+        return (width + word_bits - 1) / word_bits;
+    }
+
+    [[nodiscard]] auto pack(matrix<bool const *> const &input)
+    {
+        auto const &wt{ input.coords.width().len }, &ht{ input.coords.height().len };
+        auto const stride{ words_for(wt) };
+        packed_matrix<std::unique_ptr<packed_word[]>> retval{
+            wt, ht, static_cast<std::ptrdiff_t>(stride), std::make_unique<packed_word[]>(stride * ht)
+        };
+        for (std::size_t index{ 0 }; index < ht; ++index)
+            for (std::size_t jndex{ 0 }; jndex < wt; ++jndex)
+                if (input.data[input.coords[{ jndex, index }].to_scalar()])
+                    retval.data[index * stride + jndex / word_bits] |= packed_word{ 1 } << jndex % word_bits;
+        return retval;
+    }
+
+    namespace _internal
+    {
+        //One row of solve's sweep: label the cells of a row from their left and upper neighbors
+        //odd_row only matters for the hex lattice
+        template<connectivity conn = connectivity::four, typename tree_t, typename cell_t>
+        void scan_row(tree_t &known, std::size_t len,
+            tree::node const *prevline, tree::node *curline, cell_t const &cell, bool odd_row = false)
+        {
+            auto prev{ blank };
+            for (std::size_t jndex{ 0 }; jndex < len; ++jndex)
+            {
+                if constexpr (connectivity::four == conn)
+                {
+                    if (!cell(jndex))
+                        //Not a 1; irrelevant
+                        prev = blank;
+                    else if (blank == prevline[jndex] && blank == prev)
+                        //New island!
+                        prev = known.add_new();
+                    else if (blank == prevline[jndex] && blank != prev)
+                        //Infer from left
+                        ;
+                    else if (blank != prevline[jndex] && blank == prev)
+                        //Infer from top
+                        prev = prevline[jndex];
+                    else
+                        //blank != prevline[jndex] && blank != prev
+                        //Hard case: islands coalesce
+                        //Can reuse prev, but the meaning (id) of that island changes
+                        known.coalesce(prev, prevline[jndex]);
+                }
+                else if (!cell(jndex))
+                    prev = blank;
+                else
+                {
+                    //Infer from (or coalesce with) each upper neighbor in turn
+                    auto const join{ [&](tree::node above)
+                        {
+                            if (blank == above)
+                                ;
+                            else if (blank == prev)
+                                prev = above;
+                            else
+                                known.coalesce(prev, above);
+                        } };
+                    if constexpr (connectivity::eight == conn)
+                    {
+                        //Directly above touches both diagonals, so is already one island with them
+                        if (blank != prevline[jndex])
+                            join(prevline[jndex]);
+                        else
+                        {
+                            if (jndex)
+                                join(prevline[jndex - 1]);
+                            if (jndex + 1 < len)
+                                join(prevline[jndex + 1]);
+                        }
+                    }
+                    else
+                    {
+                        //Even rows touch above and above-left; odd rows above and above-right
+                        if (odd_row || jndex)
+                            join(prevline[jndex - !odd_row]);
+                        if (jndex + odd_row < len)
+                            join(prevline[jndex + odd_row]);
+                    }
+                    if (blank == prev)
+                        //New island!
+                        prev = known.add_new();
+                }
+                curline[jndex] = prev;
+            }
+        }
+
+        //Horizontal run of 1s, [start, stop)
+        struct run
+        {
+            std::size_t start, stop;
+            tree::node id;
+        };
+
+        //Labels runs instead of cells: each run is merged against the overlapping runs of the
+        //previous row with a two-pointer sweep, so work scales with the number of runs
+        //If record_t isn't void, also keeps a record_t (see island_area) per island
+        template<typename record_t = void>
+        class run_merger
+        {
+            static constexpr auto const keep_records{ !std::is_void_v<record_t> };
+            tree known;
+            std::vector<run> prevline, curline;
+            std::size_t above{ 0 }; //First run of prevline that might touch the next run pushed
+            std::size_t row{ 0 };
+            //Indexed by id, not root; records are only folded into their roots at the end,
+            //which is the same thing for a monoid, but saves tracing a root per run
+            std::vector<std::conditional_t<keep_records, record_t, char>> records;
+        public:
+            //Runs in a row must be pushed left to right
+            void push(std::size_t start, std::size_t stop)
+            {
+                auto const &prev_ct{ prevline.size() };
+                //Runs above that end before this one starts can't touch this or any later run
+                while (above < prev_ct && prevline[above].stop <= start)
+                    ++above;
+                auto id{ blank };
+                std::size_t overlap{ 0 }; //Cells with a 1 directly above
+                for (auto touch{ above }; touch < prev_ct && prevline[touch].start < stop; ++touch)
+                {
+                    if constexpr (keep_records)
+                        overlap += std::min(stop, prevline[touch].stop) - std::max(start, prevline[touch].start);
+                    if (blank == id)
+                        //Infer from top
+                        id = prevline[touch].id;
+                    else
+                        //Islands coalesce
+                        known.coalesce(id, prevline[touch].id);
+                }
+                if (blank == id)
+                {
+                    //New island!
+                    id = known.add_new();
+                    if constexpr (keep_records)
+                        records.emplace_back();
+                }
+                if constexpr (keep_records)
+                    records[id].add_run(row, start, stop, overlap);
+                curline.push_back({ start, stop, id });
+            }
+            void next_row(void)
+            {
+                std::swap(prevline, curline);
+                curline.clear();
+                above = 0;
+                ++row;
+            }
+            //Start over on a new grid, keeping every buffer's storage
+            void clear(void) noexcept
+            {
+                known.clear();
+                prevline.clear();
+                curline.clear();
+                above = row = 0;
+                records.clear();
+            }
+            //One record per island, in order of each island's root
+            [[nodiscard]] auto take_records(void) requires keep_records
+            {
+                for (tree::node id{ 0 }; id < records.size(); ++id)
+                    if (auto const root{ known.trace_root(id) }; root != id)
+                        records[root].fold(records[id]);
+                std::vector<record_t> retval;
+                retval.reserve(known.count_roots());
+                for (tree::node id{ 0 }; id < records.size(); ++id)
+                    if (known.trace_root(id) == id)
+                        retval.push_back(std::move(records[id]));
+                return retval;
+            }
+            [[nodiscard]] auto count(void) const noexcept { return known.count_roots(); }
+        };
+    }
+
+    namespace _internal
+    {
+        //Bit tricks for walking a packed_word in column order
+        template<bit_order order>
+        struct bit_walk abstract final
+        {
+            static constexpr auto const lsb{ bit_order::lsb_first == order };
+            [[nodiscard]] static std::size_t first_one(packed_word bits) noexcept
+            {
+                if constexpr (lsb) return std::countr_zero(bits); else return std::countl_zero(bits);
+            }
+            //Length of the run of 1s starting at column start (start < word_bits)
+            [[nodiscard]] static std::size_t ones_from(packed_word bits, std::size_t start) noexcept
+            {
+                if constexpr (lsb) return std::countr_one(bits >> start); else return std::countl_one(bits << start);
+            }
+            //Zero out the first count columns (count < word_bits)
+            [[nodiscard]] static packed_word clear_first(packed_word bits, std::size_t count) noexcept
+            {
+                if constexpr (lsb) return bits & ~packed_word{ 0 } << count; else return bits & ~packed_word{ 0 } >> count;
+            }
+            //Columns [word * word_bits, (word + 1) * word_bits) of a row of units elements
+            template<std::unsigned_integral word_t>
+            [[nodiscard]] static packed_word load(word_t const *row, std::size_t word, std::size_t units) noexcept
+            {
+                constexpr std::size_t const digits{ std::numeric_limits<word_t>::digits }, per{ word_bits / digits };
+                static_assert(per && word_bits == per * digits);
+                if constexpr (1 == per)
+                    return row[word];
+                else
+                {
+                    //Bytes of a PBM row, say; shift each into place rather than assume an alignment
+                    packed_word retval{ 0 };
+                    auto const first{ word * per }, stop{ std::min(units, first + per) };
+                    for (auto index{ first }; index < stop; ++index)
+                        retval |= packed_word{ row[index] } << digits * (lsb ? index - first : per - 1 - (index - first));
+                    return retval;
+                }
+            }
+        };
+    }
+
+    template<std::unsigned_integral word_t, bit_order order>
+    [[nodiscard]] std::size_t solve(packed_matrix<word_t const *, order> const &input)
+    {
+        using namespace _internal;
+        typedef bit_walk<order> walk;
+        run_merger<> runs;
+        auto const words{ words_for(input.width) };
+        auto const units{ (input.width + std::numeric_limits<word_t>::digits - 1) / std::numeric_limits<word_t>::digits };
+        //Mask for the valid bits of the last word of each row
+        auto const tail{ input.width % word_bits ?
+            ~walk::clear_first(~packed_word{ 0 }, input.width % word_bits) :
+            ~packed_word{ 0 } };
+        auto row{ input.data };
+        for (std::size_t index{ 0 }; index < input.height; ++index, row += input.stride)
+        {
+            //A run still open at the end of a word continues into the next
+            auto in_run{ false };
+            std::size_t open{ 0 };
+            for (std::size_t word{ 0 }; word < words; ++word)
+            {
+                auto bits{ walk::load(row, word, units) };
+                if (word + 1 == words)
+                    bits &= tail;
+                auto const base{ word * word_bits };
+                if (in_run)
+                {
+                    if (!~bits)
+                        //Run spans the whole word
+                        continue;
+                    auto const ones{ walk::ones_from(bits, 0) };
+                    runs.push(open, base + ones);
+                    in_run = false;
+                    bits = walk::clear_first(bits, ones);
+                }
+                //Whole words of 0s fall straight through
+                while (bits)
+                {
+                    auto const start{ walk::first_one(bits) };
+                    auto const stop{ start + walk::ones_from(bits, start) };
+                    if (word_bits == stop)
+                    {
+                        open = base + start;
+                        in_run = true;
+                        break;
+                    }
+                    runs.push(base + start, base + stop);
+                    bits = walk::clear_first(bits, stop);
+                }
+            }
+            if (in_run)
+                runs.push(open, input.width);
+            runs.next_row();
+        }
+        return runs.count();
+    }
+
+    namespace _internal
+    {
+        //Rows of a column-major grid are gathered into a tile this size (at most), so each cache line
+        //of a column is fetched once per tile rather than once per row
+        constexpr std::size_t const tile_bytes{ 1 << 18 }, tile_rows{ 64 };
+    }
+
+    //tree_t picks the union-find policy; see containers::basic_tree
+    //Runs a raw-pointer kernel along whichever axis has unit stride
+    template<connectivity conn = connectivity::four, typename tree_t = containers::tree>
     [[nodiscard]] std::size_t solve(matrix<bool const *> const &input)
     {
         using namespace _internal;
+        auto wt{ input.coords.width() }, ht{ input.coords.height() };
+        //Islands don't care which way they're swept, except on the hex lattice, whose rows are special
+        if constexpr (connectivity::hex != conn)
+            if (1 != wt.stride && 1 == ht.stride)
+                std::swap(wt, ht);
         //Forest of trees of island id
         //Island id is real if it "points" to itself; otherwise points to island coalesced with it
-        //When two islands merge, we pick a root arbitrarily (the lesser) and 
-        //make each root point there (so the lesser is real, b/c it points to itself)
-        containers::tree known;
+        //When two islands merge, we pick a root (per tree_t's linking policy) and 
+        //make the other root point there (so the chosen one is real, b/c it points to itself)
+        tree_t known;
         //Avoid excess heap traffic by allocating outside the loop
-        auto const &len{ input.coords.width().len };
+        auto const &len{ wt.len };
         //Island ids for each point on the boundary between the studied and unstudied regions
         auto prevline{ std::make_unique_for_overwrite<tree::node[]>(len) }, //studied boundary
             curline{ std::make_unique_for_overwrite<tree::node[]>(len) }; //unstudied boundary
-        //std::vector<id_key> prevline(len), //studied boundary
-        //    curline(len); //unstudied boundary
         //Initially no islands in empty studied region
         std::uninitialized_fill_n(prevline.get(), len, blank);
-        //We overwrite curline, so garbage data in there is OK
-        for (std::size_t index{ 0 }; index < input.coords.height().len; ++index)
+        auto const origin{ input.data + input.coords.start };
+        auto const row_at{ [&](std::size_t index)
+            { return origin + static_cast<std::ptrdiff_t>(index) * ht.stride; } };
+        auto const sweep{ [&](std::size_t index, auto const &cell)
+            {
+                scan_row<conn>(known, len, prevline.get(), curline.get(), cell, index % 2);
+                //We overwrite curline, so garbage data in there is OK
+                std::swap(prevline, curline);
+            } };
+        if (1 == wt.stride)
+            for (std::size_t index{ 0 }; index < ht.len; ++index)
+                sweep(index, [row{ row_at(index) }](std::size_t jndex) { return row[jndex]; });
+        else if (1 == ht.stride)
         {
-            auto prev{ blank };
-            for (std::size_t jndex{ 0 }; jndex < len; ++jndex)
+            //Column-major hex grid: gather a tile of rows at a time, reading down each column
+            auto const block{
+                std::clamp<std::size_t>(tile_bytes / std::max<std::size_t>(len, 1), 1, tile_rows)
+            };
+            auto const tile{ std::make_unique_for_overwrite<bool[]>(block * len) };
+            for (std::size_t index{ 0 }; index < ht.len; index += block)
             {
-                if (!input.data[input.coords[{ jndex, index }].to_scalar()])
-                    //Not a 1; irrelevant
-                    prev = blank;
-                else if (blank == prevline[jndex] && blank == prev)
-                    //New island!
-                    prev = known.add_new();
-                else if (blank == prevline[jndex] && blank != prev)
-                    //Infer from left
-                    ;
-                else if (blank != prevline[jndex] && blank == prev)
-                    //Infer from top
-                    prev = prevline[jndex];
+                auto const rows{ std::min(block, ht.len - index) };
+                for (std::size_t jndex{ 0 }; jndex < len; ++jndex)
+                {
+                    auto const column{ row_at(index) + static_cast<std::ptrdiff_t>(jndex) * wt.stride };
+                    for (std::size_t row{ 0 }; row < rows; ++row)
+                        tile[row * len + jndex] = column[row];
+                }
+                for (std::size_t row{ 0 }; row < rows; ++row)
+                    sweep(index + row,
+                        [cells{ tile.get() + row * len }](std::size_t jndex) { return cells[jndex]; });
+            }
+        }
+        else
+            for (std::size_t index{ 0 }; index < ht.len; ++index)
+                sweep(index, [row{ row_at(index) }, stride{ wt.stride }](std::size_t jndex)
+                    { return row[static_cast<std::ptrdiff_t>(jndex) * stride]; });
+        return known.count_roots();
+    }
+
+    //solve for any other rank (voxel volumes, say), counting only face-adjacent cells as touching
+    //Sweeps the last axis a hyperplane at a time; where solve keeps a row of ids as its boundary,
+    //this keeps a whole hyperplane of them
+    template<std::size_t dim, typename tree_t = containers::tree>
+        requires (2 != dim)
+    [[nodiscard]] std::size_t solve(matrix<bool const *, dim> const &input)
+    {
+        using namespace _internal;
+        static_assert(dim > 0);
+        tree_t known;
+        auto const &axes{ input.coords.indices };
+        //Ids are packed densely within a hyperplane, axis 0 fastest; pitch is the step along each axis
+        std::size_t pitch[dim];
+        pitch[0] = 1;
+        for (std::size_t axis{ 1 }; axis < dim; ++axis)
+            pitch[axis] = pitch[axis - 1] * axes[axis - 1].len;
+        auto const &plane{ pitch[dim - 1] };
+        auto prevplane{ std::make_unique_for_overwrite<tree::node[]>(plane) }, //studied boundary
+            curplane{ std::make_unique_for_overwrite<tree::node[]>(plane) }; //unstudied boundary
+        //Initially no islands in empty studied region
+        std::uninitialized_fill_n(prevplane.get(), plane, blank);
+        for (std::size_t layer{ 0 }; layer < axes[dim - 1].len; ++layer)
+        {
+            auto const cells{ input.data + input.coords.start + static_cast<std::ptrdiff_t>(layer) * axes[dim - 1].stride };
+            //Position within the hyperplane, and the matching offset into the input
+            std::size_t at[dim]{};
+            std::ptrdiff_t offset{ 0 };
+            for (std::size_t cell{ 0 }; cell < plane; ++cell)
+            {
+                auto &id{ curplane[cell] };
+                if (!cells[offset])
+                    id = blank;
                 else
-                    //blank != prevline[jndex] && blank != prev
-                    //Hard case: islands coalesce
-                    //Can reuse prev, but the meaning (id) of that island changes
-                    known.coalesce(prev, prevline[jndex]);
-                curline[jndex] = prev;
+                {
+                    //Infer from the layer below, then from (or coalesce with) each earlier neighbor
+                    //in this layer
+                    id = prevplane[cell];
+                    for (std::size_t axis{ 0 }; axis + 1 < dim; ++axis)
+                        if (at[axis])
+                        {
+                            auto const other{ curplane[cell - pitch[axis]] };
+                            if (blank == other)
+                                ;
+                            else if (blank == id)
+                                id = other;
+                            else
+                                known.coalesce(id, other);
+                        }
+                    if (blank == id)
+                        //New island!
+                        id = known.add_new();
+                }
+                //Step to the next cell, carrying into the slower axes like an odometer
+                for (std::size_t axis{ 0 }; axis + 1 < dim; ++axis)
+                {
+                    offset += axes[axis].stride;
+                    if (++at[axis] < axes[axis].len)
+                        break;
+                    offset -= static_cast<std::ptrdiff_t>(at[axis]) * axes[axis].stride;
+                    at[axis] = 0;
+                }
             }
-            //We overwrite curline, so garbage data in there is OK
-            std::swap(prevline, curline);
+            //We overwrite curplane, so garbage data in there is OK
+            std::swap(prevplane, curplane);
         }
-        //std::cout <<
-        //    "For " << data.width.len << "x" << data.height.len << " matrix, "
-        //    "used " << size(known) << " id(s)." << std::endl;
         return known.count_roots();
     }
 
+    //Connected-component labeling: writes each cell's island into output (row-major, width x height),
+    //numbered 1, 2, ... in order of each island's first cell, with 0 for water, and returns the count
+    //The first pass is solve's, writing each row's provisional ids straight out; the second resolves
+    //them to their roots' labels in place, so output can be a mapped file (see mapped::label_map)
+    template<connectivity conn = connectivity::four, typename tree_t = containers::tree,
+        std::unsigned_integral label_t>
+    std::size_t label(matrix<bool const *> const &input, std::span<label_t> output)
+    {
+        using namespace _internal;
+        auto const &wt{ input.coords.width() }, &ht{ input.coords.height() };
+        auto const &len{ wt.len };
+        assert(output.size() >= len * ht.len);
+        tree_t known;
+        auto prevline{ std::make_unique_for_overwrite<tree::node[]>(len) },
+            curline{ std::make_unique_for_overwrite<tree::node[]>(len) };
+        std::uninitialized_fill_n(prevline.get(), len, blank);
+        for (std::size_t index{ 0 }; index < ht.len; ++index)
+        {
+            auto const row{ input.data + input.coords.start + static_cast<std::ptrdiff_t>(index) * ht.stride };
+            if (1 == wt.stride)
+                scan_row<conn>(known, len, prevline.get(), curline.get(),
+                    [row](std::size_t jndex) { return row[jndex]; }, index % 2);
+            else
+                scan_row<conn>(known, len, prevline.get(), curline.get(),
+                    [row, stride{ wt.stride }](std::size_t jndex)
+                    { return row[static_cast<std::ptrdiff_t>(jndex) * stride]; }, index % 2);
+            //Checked before the row is written, so no id ever gets stored wrapped
+            if (known.size() > std::numeric_limits<label_t>::max())
+                throw std::overflow_error("Too many provisional labels for the label type");
+            //Shifted up one, so 0 is free for water
+            std::transform(curline.get(), curline.get() + len, output.data() + index * len,
+                [](tree::node id) { return static_cast<label_t>(id + 1); });
+            std::swap(prevline, curline);
+        }
+        //Ids are handed out in scan order, so numbering each island when its lowest id comes up
+        //numbers islands by first cell; a root above the id being resolved gets its label early
+        std::vector<label_t> resolved(known.size());
+        label_t count{ 0 };
+        for (tree::node id{ 0 }; id < known.size(); ++id)
+        {
+            auto &root{ resolved[known.trace_root(id)] };
+            if (!root)
+                root = ++count;
+            resolved[id] = root;
+        }
+        for (auto &cell : output.first(len * ht.len))
+            if (cell)
+                cell = resolved[cell - 1];
+        return count;
+    }
+
+    namespace _internal
+    {
+        //Scratch for relabel_roots; relabel stays all blank between calls, so it is never cleared
+        struct relabel_scratch
+        {
+            std::vector<tree::node> relabel, order;
+        };
+
+        //Renumbers the ids on each line to 0, 1, ... by root, in order of first appearance, and returns
+        //how many roots there were
+        //Ids are bounded by the tree's size, so a direct-address table stands in for sorting them;
+        //once the scratch has grown to fit, this never allocates
+        template<typename tree_t>
+        std::size_t relabel_roots(tree_t &known, std::initializer_list<std::span<tree::node>> lines,
+            relabel_scratch &scratch)
+        {
+            auto &[relabel, order] { scratch };
+            if (relabel.size() < known.size())
+                relabel.resize(known.size(), blank);
+            order.clear();
+            for (auto const &line : lines)
+                for (auto &id : line)
+                    if (blank != id)
+                    {
+                        auto const root{ known.trace_root(id) };
+                        if (blank == relabel[root])
+                        {
+                            relabel[root] = order.size();
+                            order.push_back(root);
+                        }
+                        id = relabel[root];
+                    }
+            for (auto const root : order)
+                relabel[root] = blank;
+            return order.size();
+        }
+    }
+
+    //solve, fed a row at a time: memory is O(width) however many rows come through
+    //Ids that have left the boundary are garbage-collected once the tree outgrows recycle_at
+    class stream
+    {
+        std::size_t const width, recycle_at;
+        containers::tree known;
+        std::unique_ptr<containers::tree::node[]> prevline, curline;
+        _internal::relabel_scratch scratch;
+        std::size_t finished{ 0 }; //Islands no longer on the boundary, and so complete
+        void recycle(void)
+        {
+            //Same as solve2's partial_soln::normalize
+            auto const roots{ known.count_roots() };
+            auto const live{ _internal::relabel_roots(known, { { prevline.get(), width } }, scratch) };
+            finished += roots - live;
+            known.reset(live);
+        }
+    public:
+        explicit stream(std::size_t width, std::size_t recycle_at) :
+            width{ width }, recycle_at{ recycle_at },
+            prevline{ std::make_unique_for_overwrite<containers::tree::node[]>(width) },
+            curline{ std::make_unique_for_overwrite<containers::tree::node[]>(width) }
+        {
+            std::uninitialized_fill_n(prevline.get(), width, _internal::blank);
+        }
+        //A row holds at most (width + 1) / 2 islands, so this keeps the tree O(width)
+        explicit stream(std::size_t width) : stream(width, 2 * width + 64) {}
+        void push(matrix<bool const *, 1> const &row)
+        {
+            auto const &axis{ row.coords.indices[0] };
+            assert(width == axis.len);
+            auto const cells{ row.data + row.coords.start };
+            _internal::scan_row(known, width, prevline.get(), curline.get(),
+                [cells, &axis](std::size_t jndex) { return cells[jndex * axis.stride]; });
+            std::swap(prevline, curline);
+            if (known.size() > recycle_at)
+                recycle();
+        }
+        [[nodiscard]] std::size_t count(void) const noexcept { return finished + known.count_roots(); }
+    };
+
+    //Producer fills each row it's handed with width cells, and returns false once out of rows
+    template<std::invocable<bool *> producer_t>
+    [[nodiscard]] std::size_t solve_stream(std::size_t width, producer_t &&fill_row)
+    {
+        stream sweep(width);
+        auto const row{ std::make_unique_for_overwrite<bool[]>(width) };
+        while (fill_row(row.get()))
+            sweep.push({ lin_alg3::slice<>(0, { width }), row.get() });
+        return sweep.count();
+    }
+
+    //Each element of rows is a contiguous row of width cells
+    template<std::ranges::input_range rows_t>
+    [[nodiscard]] std::size_t solve_stream(std::size_t width, rows_t &&rows)
+    {
+        stream sweep(width);
+        for (auto const &row : rows)
+        {
+            assert(width == std::ranges::size(row));
+            sweep.push({ lin_alg3::slice<>(0, { width }), std::ranges::data(row) });
+        }
+        return sweep.count();
+    }
+
+    //Island count under "rising land": cells only ever flip from 0 to 1, and the count is kept live
+    class incremental
+    {
+        std::size_t const width, height;
+        containers::tree known;
+        std::unique_ptr<containers::tree::node[]> ids; //Island id of each cell, or blank for 0s
+        std::size_t islands{ 0 };
+    public:
+        incremental(std::size_t width, std::size_t height) :
+            width{ width }, height{ height },
+            ids{ std::make_unique_for_overwrite<containers::tree::node[]>(width * height) }
+        {
+            std::uninitialized_fill_n(ids.get(), width * height, _internal::blank);
+        }
+        //O(alpha(n)) amortized: at most four merges
+        void set(std::size_t x, std::size_t y)
+        {
+            using _internal::blank;
+            assert(x < width && y < height);
+            auto &id{ ids[y * width + x] };
+            if (blank != id)
+                return;
+            id = known.add_new();
+            ++islands;
+            auto const merge_with{ [&](std::size_t nx, std::size_t ny)
+                {
+                    auto const other{ ids[ny * width + nx] };
+                    if (blank == other)
+                        return;
+                    auto const lhs{ known.trace_root(id) }, rhs{ known.trace_root(other) };
+                    if (lhs == rhs)
+                        return;
+                    known.coalesce_nocheck(lhs, rhs);
+                    --islands;
+                } };
+            if (x)
+                merge_with(x - 1, y);
+            if (x + 1 < width)
+                merge_with(x + 1, y);
+            if (y)
+                merge_with(x, y - 1);
+            if (y + 1 < height)
+                merge_with(x, y + 1);
+        }
+        [[nodiscard]] bool get(std::size_t x, std::size_t y) const noexcept
+        {
+            assert(x < width && y < height);
+            return _internal::blank != ids[y * width + x];
+        }
+        [[nodiscard]] std::size_t count(void) const noexcept { return islands; }
+    };
+
+    //Newman-Ziff sweep: occupies the cells of a width x height grid one at a time, in the order given
+    //(as row-major indices, each cell once), and returns the island count after each, so counts[n] is
+    //the count with the first n cells of order land
+    //One O(N alpha(N)) pass stands in for a solve per occupation probability; see percolation_curve
+    template<connectivity conn = connectivity::four>
+    [[nodiscard]] std::vector<std::size_t> percolation_sweep(std::size_t width, std::size_t height,
+        std::span<std::size_t const> order)
+    {
+        using _internal::tree;
+        assert(order.size() <= width * height);
+        //Cell index is node index, so no ids to look up; a cell is land once it's in the order so far
+        tree known(width * height);
+        std::vector<char> land(width * height);
+        std::vector<std::size_t> retval;
+        retval.reserve(order.size() + 1);
+        std::size_t islands{ 0 };
+        retval.push_back(islands);
+        for (auto const cell : order)
+        {
+            assert(cell < width * height && !land[cell]);
+            land[cell] = true;
+            ++islands;
+            auto const x{ cell % width }, y{ cell / width };
+            auto const merge_with{ [&](std::size_t nx, std::size_t ny)
+                {
+                    //Unsigned wraparound takes care of the left and top edges
+                    if (nx >= width || ny >= height || !land[ny * width + nx])
+                        return;
+                    auto const lhs{ known.trace_root(cell) }, rhs{ known.trace_root(ny * width + nx) };
+                    if (lhs == rhs)
+                        return;
+                    known.coalesce_nocheck(lhs, rhs);
+                    --islands;
+                } };
+            merge_with(x - 1, y);
+            merge_with(x + 1, y);
+            merge_with(x, y - 1);
+            merge_with(x, y + 1);
+            if constexpr (connectivity::eight == conn)
+                for (auto const ny : { y - 1, y + 1 })
+                {
+                    merge_with(x - 1, ny);
+                    merge_with(x + 1, ny);
+                }
+            else if constexpr (connectivity::hex == conn)
+            {
+                //Even rows touch the row above and below to the left, odd rows to the right
+                auto const diagonal{ y % 2 ? x + 1 : x - 1 };
+                merge_with(diagonal, y - 1);
+                merge_with(diagonal, y + 1);
+            }
+            retval.push_back(islands);
+        }
+        return retval;
+    }
+
+    //Same, over a random order of every cell
+    template<connectivity conn = connectivity::four, std::uniform_random_bit_generator urng_t>
+    [[nodiscard]] std::vector<std::size_t> percolation_sweep(std::size_t width, std::size_t height, urng_t &rng)
+    {
+        std::vector<std::size_t> order(width * height);
+        std::iota(begin(order), end(order), std::size_t{ 0 });
+        std::shuffle(begin(order), end(order), rng);
+        return percolation_sweep<conn>(width, height, order);
+    }
+
+    //Expected island count when each cell is land with probability p, from a full sweep's counts:
+    //the counts averaged over how many cells are land, weighted binomially
+    [[nodiscard]] double percolation_curve(std::span<std::size_t const> counts, double p)
+    {
+        assert(!counts.empty() && 0 <= p && p <= 1);
+        auto const cells{ counts.size() - 1 };
+        if (p <= 0)
+            return static_cast<double>(counts.front());
+        if (p >= 1)
+            return static_cast<double>(counts.back());
+        //In logs, since the binomial coefficients overflow a double long before the grid gets big
+        auto const log_p{ std::log(p) }, log_q{ std::log1p(-p) }, log_all{ std::lgamma(cells + 1.) };
+        double retval{ 0 };
+        for (std::size_t land{ 0 }; land <= cells; ++land)
+            retval += counts[land] * std::exp(log_all - std::lgamma(land + 1.) - std::lgamma(cells - land + 1.) +
+                land * log_p + (cells - land) * log_q);
+        return retval;
+    }
+
     namespace _internal
     {
+        //Lines of ids for solve2's partial solutions, all one width, carved out of slabs
+        //Merges hand their spent lines back for reuse, so once the first slab is sized for the
+        //recursion (see serial_lines), a whole solve makes a fixed handful of heap allocations,
+        //and peak memory is that slab
+        //If the estimate falls short, it grows by another slab rather than fail
+        class line_pool
+        {
+            std::size_t const width;
+            std::size_t total{ 0 };
+            std::vector<std::unique_ptr<tree::node[]>> slabs;
+            std::vector<tree::node *> free;
+            bool const shared; //Only the parallel solve's workers share a pool, and only they lock it
+            std::mutex lock;
+            void grow(std::size_t lines)
+            {
+                auto const &slab{
+                    slabs.emplace_back(std::make_unique_for_overwrite<tree::node[]>(lines * width))
+                };
+                free.reserve(total += lines);
+                for (std::size_t index{ 0 }; index < lines; ++index)
+                    free.push_back(slab.get() + index * width);
+            }
+        public:
+            line_pool(std::size_t width, std::size_t lines, bool shared = false) :
+                width{ width }, shared{ shared }
+            {
+                grow(std::max<std::size_t>(lines, 1));
+            }
+            [[nodiscard]] std::span<tree::node> acquire(void)
+            {
+                std::unique_lock _guard{ lock, std::defer_lock };
+                if (shared)
+                    _guard.lock();
+                if (free.empty())
+                    grow(total);
+                auto const retval{ free.back() };
+                free.pop_back();
+                return { retval, width };
+            }
+            void release(std::span<tree::node> line)
+            {
+                std::unique_lock _guard{ lock, std::defer_lock };
+                if (shared)
+                    _guard.lock();
+                free.push_back(line.data());
+            }
+        };
+
+        //Lines live at once when solve2 recurses serially over rows rows: two for each pending left
+        //half on the way down, and two for the row in hand
+        [[nodiscard]] constexpr std::size_t serial_lines(std::size_t rows) noexcept
+        {
+            return 2 * (std::bit_width(rows) + 1);
+        }
+
+        template<connectivity conn = connectivity::four>
         struct solve2
         {
             bool const *data;
+            bool transposed{ false }; //Relative to the caller's grid; matters for the hex lattice
+            line_pool *lines{ nullptr }; //Set once the recursion knows its width
         private:
+            //One per thread, like normalize_scratch
+            inline static thread_local tree merge_tree;
+            //One per thread, so merges on the pool's workers don't collide; keeps its capacity from one
+            //merge (and solve) to the next
+            inline static thread_local relabel_scratch normalize_scratch;
             struct partial_soln
             {
                 struct side
                 {
                     lin_alg3::slice<> coords;
-                    //std::unique_ptr<tree::node[]>
-                    std::vector<tree::node> ids;
+                    std::span<tree::node> ids; //A line from the solver's line_pool
                 } left, right;
                 std::size_t ids_used{ 0 }, bulk_ct{ 0 };
-            private:
-                [[nodiscard]] auto boundary_ids(tree const &known)
-                {
-                    std::vector<tree::node> boundaries;
-                    for (auto const bdry : { &left.ids, &right.ids })
-                        for (auto &id : *bdry)
-                            if (blank != id)
-                                boundaries.emplace_back(id = known.trace_root(id));
-                    return boundaries;
-                }
-                void shrink(auto const &lookup_table)
+                //Replace boundary ids with 0, 1, ..., one per island, and record how many were used
+                void normalize(tree &known, relabel_scratch &scratch)
                 {
-                    for (auto const bdry : { &left.ids, &right.ids })
-                        for (auto &id : *bdry)
-                            if (blank != id)
-                                id = lookup_table[id];
-                }
-            public:
-                void normalize(tree const &known)
-                {
-                    //(1) Collect boundary ids
-                    auto boundaries{ boundary_ids(known) };
-                    //(2) Uniquify boundary ids
-                    decltype(cbegin(boundaries)) const last{
-                        utils::uniquify(begin(boundaries), end(boundaries))
-                    };
-                    //(3) Record number of ids used
-                    ids_used = last - cbegin(boundaries);
-                    //(4) Replace ids with order of appearance in boundaries
-                    shrink(utils::invert_injection(cbegin(boundaries), last));
+                    ids_used = relabel_roots(known, { left.ids, right.ids }, scratch);
                 }
                 void reindex_above(tree::node bound)
                 {
@@ -145,22 +884,57 @@ namespace islands
                 }
             };
 
+            //row is the index of inner_right's line in the (possibly transposed) grid
             void zip_boundaries(tree &known,
                 partial_soln::side const &inner_left,
-                partial_soln::side const &inner_right) const
+                partial_soln::side const &inner_right,
+                std::size_t row) const
             {
-                //Zip inner boundary, coalescing islands along the way
-                using std::cbegin;
-                auto il{ cbegin(inner_left.coords) }, ir{ cbegin(inner_right.coords) };
-                auto const &iri{ inner_right.ids };
-                for (auto lr{ begin(inner_left.ids) }, rl{ begin(iri) }, stop{ end(iri) };
-                    rl != stop;
-                    ++lr, ++rl, ++il, ++ir)
+                if constexpr (connectivity::four == conn)
+                {
+                    //Zip inner boundary, coalescing islands along the way
+                    using std::cbegin;
+                    auto il{ cbegin(inner_left.coords) }, ir{ cbegin(inner_right.coords) };
+                    auto const &iri{ inner_right.ids };
+                    for (auto lr{ begin(inner_left.ids) }, rl{ begin(iri) }, stop{ end(iri) };
+                        rl != stop;
+                        ++lr, ++rl, ++il, ++ir)
 
-                    if (il[data] && ir[data])
-                        //Since we've already disjointified the left & right ids,
-                        //*lr and *rl will always differ
-                        known.coalesce_nocheck(*lr, *rl);
+                        if (il[data] && ir[data])
+                            //Since we've already disjointified the left & right ids,
+                            //*lr and *rl will always differ
+                            known.coalesce_nocheck(*lr, *rl);
+                }
+                else
+                {
+                    //Blank ids mark the 0s, so no need to go back to the data
+                    auto const &above{ inner_left.ids }, &below{ inner_right.ids };
+                    auto const len{ size(below) };
+                    auto const join{ [&](std::size_t to, std::size_t from)
+                        {
+                            if (blank != above[from])
+                                known.coalesce_nocheck(above[from], below[to]);
+                        } };
+                    for (std::size_t index{ 0 }; index < len; ++index)
+                        if (blank != below[index])
+                        {
+                            join(index, index);
+                            //Whether the cell touches the diagonals at index - 1 and index + 1
+                            bool down, up;
+                            if constexpr (connectivity::eight == conn)
+                                down = up = true;
+                            else if (transposed)
+                                //Lines are columns: a cell in an even row reaches back a column
+                                down = up = !(index % 2);
+                            else
+                                //Even rows touch above-left, odd rows above-right
+                                up = !(down = !(row % 2));
+                            if (down && index)
+                                join(index, index - 1);
+                            if (up && index + 1 < len)
+                                join(index, index + 1);
+                        }
+                }
             }
 
             void check_sizes(partial_soln::side const &inner_left, partial_soln::side const &inner_right)
@@ -175,8 +949,11 @@ namespace islands
                 assert(shift == 1 && walk_data.stride > 1 || shift == walk_data.len * walk_data.stride);
             }
 
-            [[nodiscard]] partial_soln merge(partial_soln &&lhs, partial_soln &&rhs) const
+            //rows is the height of the merged band, for the stats
+            [[nodiscard]] partial_soln merge(partial_soln &&lhs, partial_soln &&rhs, std::size_t row,
+                [[maybe_unused]] std::size_t rows) const
             {
+                stats::stopwatch const _timing{ &stats::counters::merge };
                 auto const &inner_left{ lhs.right }, &inner_right{ rhs.left };
                 check_sizes(inner_left, inner_right);
                 rhs.reindex_above(lhs.ids_used);
@@ -187,18 +964,32 @@ namespace islands
                     lhs.bulk_ct + rhs.bulk_ct
                 };
                 //Build id table
-                tree known(retval.ids_used);
-                zip_boundaries(known, inner_left, inner_right);
+                auto &known{ merge_tree };
+                known.reset(retval.ids_used);
+                zip_boundaries(known, inner_left, inner_right, row);
+                //Inner boundaries are spent
+                lines->release(inner_left.ids);
+                lines->release(inner_right.ids);
                 //Assume everything goes into the bulk until proven otherwise
                 retval.bulk_ct += known.count_roots();
-                retval.normalize(known);
+                {
+                    stats::stopwatch const _timing{ &stats::counters::normalize };
+                    retval.normalize(known, normalize_scratch);
+                }
                 retval.bulk_ct -= retval.ids_used;
+                if constexpr (stats::enabled)
+                {
+                    auto &counts{ stats::local() };
+                    auto const level{ std::bit_width(rows - 1) };
+                    ++counts.merges[level];
+                    counts.ids[level] += retval.ids_used;
+                }
                 return retval;
             }
 
             inline [[nodiscard]] partial_soln analyze(lin_alg3::slice<> const &input) const
             {
-                partial_soln retval{ { input, std::vector<tree::node>(input.indices[0].len) } };
+                partial_soln retval{ { input, lines->acquire() } };
                 {
                     using std::begin;
                     auto prev{ blank };
@@ -213,16 +1004,15 @@ namespace islands
                         data_iter++;
                     }
                 }
-                retval.right = retval.left;
+                retval.right = { input, lines->acquire() };
+                std::ranges::copy(retval.left.ids, begin(retval.right.ids));
                 return retval;
             }
-            public:
-            [[nodiscard]] partial_soln operator()(lin_alg3::slice<2> const &coords) const
+            //Rows [first, first + height) of the (possibly transposed) grid
+            [[nodiscard]] partial_soln band(lin_alg3::slice<2> const &coords, std::size_t first) const
             {
                 auto const &ht{ coords.height().len };
-                assert(ht);
-                if (ht > coords.width().len)
-                    return (*this)(transpose(coords));
+                assert(ht && ht <= coords.width().len);
                 if (1 == ht)
                     return analyze(coerce<1>(coords));
                 else
@@ -230,69 +1020,1034 @@ namespace islands
                     using lin_alg::all_t;
                     auto const split_pt{ ht / 2 };
                     lin_alg3::slice<> const left(0, { split_pt }), right(split_pt, { ht - split_pt });
-                    return merge((*this)(coords[{all_t{}, left}]), (*this)(coords[{all_t{}, right}]));
+                    return merge(band(coords[{all_t{}, left}], first),
+                        band(coords[{all_t{}, right}], first + split_pt),
+                        first + split_pt, ht);
                 }
             }
+            [[nodiscard]] static std::size_t count(partial_soln const &soln) noexcept
+            {
+                return soln.bulk_ct + soln.ids_used;
+            }
+            public:
+            [[nodiscard]] std::size_t operator()(lin_alg3::slice<2> const &coords) const
+            {
+                auto const &ht{ coords.height().len }, &wt{ coords.width().len };
+                assert(ht);
+                //Halving never makes a band taller than it is wide, so this only happens up top
+                if (ht > wt)
+                    return solve2{ data, !transposed }(transpose(coords));
+                line_pool pool(wt, serial_lines(ht));
+                return count(solve2{ data, transposed, &pool }.band(coords, 0));
+            }
+            //Same recursion, but the halves run as tasks on the pool until they fit in grain cells
+            [[nodiscard]] std::size_t operator()(lin_alg3::slice<2> const &coords,
+                tasks::pool &workers, std::size_t grain) const
+            {
+                auto const &ht{ coords.height().len }, &wt{ coords.width().len };
+                assert(ht);
+                if (ht > wt)
+                    return solve2{ data, !transposed }(transpose(coords), workers, grain);
+                //Two lines per band waiting on its sibling, plus each worker's own serial recursion
+                auto const rows{ std::max<std::size_t>(grain / wt, 1) };
+                line_pool pool(wt, 4 * ((ht + rows - 1) / rows) + workers.size() * serial_lines(rows),
+                    true);
+                return count(forked{ solve2{ data, transposed, &pool }, workers, grain }(coords));
+            }
+        private:
+            class forked
+            {
+                //Meeting point of two halves; whichever finishes second merges them (continuation)
+                struct join
+                {
+                    std::shared_ptr<join> parent;
+                    int slot;
+                    std::size_t row; //First row of the right half
+                    std::size_t rows; //Of both halves together
+                    std::atomic<int> pending{ 2 };
+                    std::optional<partial_soln> halves[2];
+                    join(std::shared_ptr<join> &&parent, int slot, std::size_t row, std::size_t rows) :
+                        parent{ std::move(parent) }, slot{ slot }, row{ row }, rows{ rows }
+                    {}
+                };
+                solve2 const serial;
+                tasks::pool &workers;
+                std::size_t const grain;
+                std::mutex lock;
+                std::condition_variable done;
+                std::size_t live{ 0 }; //Tasks spawned but not finished
+                std::optional<partial_soln> result;
+                std::exception_ptr error;
+
+                void spawn(lin_alg3::slice<2> const &coords, std::size_t first,
+                    std::shared_ptr<join> parent, int slot)
+                {
+                    {
+                        std::lock_guard _guard{ lock };
+                        ++live;
+                    }
+                    workers.spawn([this, coords, first, parent{ std::move(parent) }, slot](void) mutable
+                        {
+                            try
+                            {
+                                fork(coords, first, std::move(parent), slot);
+                            }
+                            catch (...)
+                            {
+                                std::lock_guard _guard{ lock };
+                                if (!error)
+                                    error = std::current_exception();
+                            }
+                            std::lock_guard _guard{ lock };
+                            if (!--live)
+                                done.notify_all();
+                        });
+                }
+                void fork(lin_alg3::slice<2> const &coords, std::size_t first,
+                    std::shared_ptr<join> parent, int slot)
+                {
+                    auto const &ht{ coords.height().len }, &wt{ coords.width().len };
+                    assert(ht && ht <= wt);
+                    if (1 == ht || ht * wt <= grain)
+                        return deliver(serial.band(coords, first), std::move(parent), slot);
+                    using lin_alg::all_t;
+                    auto const split_pt{ ht / 2 };
+                    lin_alg3::slice<> const left(0, { split_pt }), right(split_pt, { ht - split_pt });
+                    auto node{ std::make_shared<join>(std::move(parent), slot, first + split_pt, ht) };
+                    spawn(coords[{all_t{}, right}], first + split_pt, node, 1);
+                    //Keep the left half on this thread
+                    fork(coords[{all_t{}, left}], first, std::move(node), 0);
+                }
+                void deliver(partial_soln &&soln, std::shared_ptr<join> parent, int slot)
+                {
+                    while (parent)
+                    {
+                        parent->halves[slot] = std::move(soln);
+                        if (1 != parent->pending.fetch_sub(1, std::memory_order_acq_rel))
+                            //Sibling still running; it will do the merge
+                            return;
+                        soln = serial.merge(std::move(*parent->halves[0]), std::move(*parent->halves[1]),
+                            parent->row, parent->rows);
+                        slot = parent->slot;
+                        auto up{ std::move(parent->parent) };
+                        parent = std::move(up);
+                    }
+                    //Only the root has no parent, and only one task delivers to it
+                    result = std::move(soln);
+                }
+            public:
+                forked(solve2 const &serial, tasks::pool &workers, std::size_t grain) :
+                    serial{ serial }, workers{ workers }, grain{ grain }
+                {}
+                [[nodiscard]] partial_soln operator()(lin_alg3::slice<2> const &coords)
+                {
+                    spawn(coords, 0, nullptr, 0);
+                    std::unique_lock _guard{ lock };
+                    done.wait(_guard, [this] { return !live; });
+                    if (error)
+                        std::rethrow_exception(error);
+                    return std::move(*result);
+                }
+            };
         };
     }
 
+    template<connectivity conn = connectivity::four>
     [[nodiscard]] std::size_t solve2(matrix<bool const *> const &input)
     {
-        auto const &retval{ _internal::solve2{input.data}(input.coords) };
-        return retval.bulk_ct + retval.ids_used;
+        return _internal::solve2<conn>{ input.data }(input.coords);
+    }
+
+    //Parallel solve2: bands of at most grain cells are solved serially on the pool's workers
+    template<connectivity conn = connectivity::four>
+    [[nodiscard]] std::size_t solve2(matrix<bool const *> const &input,
+        tasks::pool &workers, std::size_t grain = std::size_t{ 1 } << 16)
+    {
+        return _internal::solve2<conn>{ input.data }(input.coords, workers, grain);
     }
 
     namespace _internal
     {
-        [[nodiscard]] auto emplace_zeros(matrix<bool const *> const &input)
+        constexpr char const summary_magic[]{ 'I', 'S', 'U', 'M' };
+        template<std::unsigned_integral uint_t>
+        void put_le(std::ostream &dest, uint_t value)
         {
-            auto const &mat{ input.coords };
-            auto const &ht{ mat.height().len }, &wt{ mat.width().len };
-            auto const new_width{ wt + 2 }, new_height{ht + 2};
-            matrix<std::unique_ptr<bool[]>> retval{
-                matrix_slice(new_width, new_height), std::make_unique<bool[]>(new_width * new_height)
-            };
-            for (std::size_t index{ 0 }; index < wt; ++index)
-                for (std::size_t jndex{ 0 }; jndex < ht; ++jndex)
-                    retval.data[retval.coords[{index + 1, jndex + 1}].to_scalar()] =
-                        input.data[mat[{index, jndex}].to_scalar()];
+            char bytes[sizeof(uint_t)];
+            for (auto &byte : bytes)
+            {
+                byte = static_cast<char>(value & 0xFF);
+                value >>= 8;
+            }
+            dest.write(bytes, sizeof bytes);
+        }
+        template<std::unsigned_integral uint_t>
+        [[nodiscard]] uint_t get_le(std::istream &src)
+        {
+            unsigned char bytes[sizeof(uint_t)];
+            if (!src.read(reinterpret_cast<char *>(bytes), sizeof bytes))
+                throw std::runtime_error("Truncated summary");
+            uint_t retval{ 0 };
+            for (auto index{ sizeof bytes }; index--; )
+                retval = retval << 8 | bytes[index];
+            return retval;
+        }
+    }
+
+    //A block of a grid as seen from outside: the ids of the islands along each of its sides, numbered
+    //0, 1, ... (blank for water), plus a count of the islands that touch none of them
+    //Sides on the grid's left or right edge stay empty, since nothing will ever merge there, so a stack
+    //of full-width bands stays O(width) however many rows it covers
+    struct summary
+    {
+        //Bumped whenever the binary format changes; read refuses any other
+        static constexpr std::uint32_t const version{ 1 };
+        connectivity conn{ connectivity::four };
+        std::size_t x{ 0 }, y{ 0 }, width{ 0 }, height{ 0 };
+        std::vector<std::size_t> top, bottom, left, right;
+        std::size_t ids_used{ 0 }, bulk_ct{ 0 };
+
+        //Islands in the block, as if everything outside it were water
+        [[nodiscard]] std::size_t count(void) const noexcept { return bulk_ct + ids_used; }
+
+        //Little-endian throughout: "ISUM", then version and connectivity in 32 bits, then x, y, width,
+        //height, ids_used, bulk_ct and the lengths of top, bottom, left and right in 64 bits, then
+        //those sides' ids in 64 bits each, all 1s for water
+        void write(std::ostream &dest) const
+        {
+            using _internal::put_le;
+            dest.write(_internal::summary_magic, sizeof _internal::summary_magic);
+            put_le<std::uint32_t>(dest, version);
+            put_le<std::uint32_t>(dest, static_cast<std::uint32_t>(conn));
+            for (std::size_t const field : { x, y, width, height, ids_used, bulk_ct,
+                size(top), size(bottom), size(left), size(right) })
+                put_le<std::uint64_t>(dest, field);
+            for (auto const bdry : { &top, &bottom, &left, &right })
+                for (auto const id : *bdry)
+                    put_le<std::uint64_t>(dest, _internal::blank == id ? ~std::uint64_t{ 0 } : id);
+            if (!dest)
+                throw std::runtime_error("Couldn't write summary");
+        }
+        [[nodiscard]] static summary read(std::istream &src)
+        {
+            using _internal::get_le;
+            char magic[sizeof _internal::summary_magic];
+            if (!src.read(magic, sizeof magic) || !std::ranges::equal(magic, _internal::summary_magic))
+                throw std::runtime_error("Not an island summary");
+            if (auto const found{ get_le<std::uint32_t>(src) }; version != found)
+                throw std::runtime_error("Unsupported summary version " + std::to_string(found));
+            summary retval;
+            auto const conn_id{ get_le<std::uint32_t>(src) };
+            if (conn_id > static_cast<std::uint32_t>(connectivity::hex))
+                throw std::runtime_error("Unknown connectivity in summary");
+            retval.conn = static_cast<connectivity>(conn_id);
+            auto const field{ [&src]
+                {
+                    auto const value{ get_le<std::uint64_t>(src) };
+                    if (value > std::numeric_limits<std::size_t>::max())
+                        throw std::runtime_error("Summary too large for this platform");
+                    return static_cast<std::size_t>(value);
+                } };
+            std::size_t lens[4];
+            for (auto const dest : { &retval.x, &retval.y, &retval.width, &retval.height,
+                &retval.ids_used, &retval.bulk_ct, lens, lens + 1, lens + 2, lens + 3 })
+                *dest = field();
+            constexpr auto const max{ std::numeric_limits<std::size_t>::max() };
+            if (lens[0] != retval.width || lens[1] != retval.width ||
+                (lens[2] && lens[2] != retval.height) || (lens[3] && lens[3] != retval.height) ||
+                retval.width > max - retval.x || retval.height > max - retval.y)
+                throw std::runtime_error("Summary sides don't fit its dimensions");
+            //normalize leaves at most an id per side cell, and no block has more islands than cells;
+            //anything more would only make merges allocate without bound, or wrap their counts
+            if (retval.width > max / 4 || retval.height > max / 4 ||
+                retval.ids_used > 2 * retval.width + lens[2] + lens[3])
+                throw std::runtime_error("Summary has more ids than side cells");
+            if (auto const cells{ retval.width > max / std::max<std::size_t>(retval.height, 1) ?
+                max : retval.width * retval.height };
+                retval.ids_used > cells || retval.bulk_ct > cells - retval.ids_used)
+                throw std::runtime_error("Summary has more islands than cells");
+            auto len{ lens };
+            //No reserve: a corrupt length runs out of input long before it runs out of memory
+            for (auto const bdry : { &retval.top, &retval.bottom, &retval.left, &retval.right })
+                for (auto count{ *len++ }; count--; )
+                    if (auto const id{ get_le<std::uint64_t>(src) }; ~std::uint64_t{ 0 } == id)
+                        bdry->push_back(_internal::blank);
+                    else if (id < retval.ids_used)
+                        bdry->push_back(static_cast<std::size_t>(id));
+                    else
+                        throw std::runtime_error("Summary id out of range");
+            return retval;
+        }
+    };
+
+    namespace _internal
+    {
+        //Replace side ids with 0, 1, ..., one per island, and move the rest into the bulk
+        void normalize(summary &soln, tree &known, relabel_scratch &scratch)
+        {
+            stats::stopwatch const _timing{ &stats::counters::normalize };
+            soln.bulk_ct += known.count_roots();
+            soln.ids_used = relabel_roots(known, { soln.top, soln.bottom, soln.left, soln.right }, scratch);
+            soln.bulk_ct -= soln.ids_used;
+        }
+        //Coalesce the islands of two sides that face each other across a seam
+        //far[index] touches near[index + offset] for offset in the range reach(index) returns
+        void zip(tree &known, std::vector<tree::node> const &near, std::vector<tree::node> const &far,
+            auto const &reach)
+        {
+            auto const len{ far.size() };
+            for (std::size_t index{ 0 }; index < len; ++index)
+                if (blank != far[index])
+                    for (auto [offset, hi] { reach(index) }; offset <= hi; ++offset)
+                        //Unsigned wraparound takes care of the start of the seam
+                        if (auto const other{ index + offset }; other < len && blank != near[other])
+                            known.coalesce(near[other], far[index]);
+        }
+        //Merge lhs with the rhs to its right (across) or below it
+        template<connectivity conn>
+        [[nodiscard]] summary merge(summary &&lhs, summary &&rhs, bool across, tree &known,
+            relabel_scratch &scratch)
+        {
+            stats::stopwatch const _timing{ &stats::counters::merge };
+            //Disjointify ids
+            for (auto const bdry : { &rhs.top, &rhs.bottom, &rhs.left, &rhs.right })
+                for (auto &id : *bdry)
+                    if (blank != id)
+                        id += lhs.ids_used;
+            known.reset(lhs.ids_used + rhs.ids_used);
+            auto const append{ [](std::vector<tree::node> &dest, std::vector<tree::node> const &src)
+                { dest.insert(end(dest), begin(src), end(src)); } };
+            summary retval{ .conn{ conn }, .x{ lhs.x }, .y{ lhs.y },
+                .width{ across ? lhs.width + rhs.width : lhs.width },
+                .height{ across ? lhs.height : lhs.height + rhs.height },
+                .bulk_ct{ lhs.bulk_ct + rhs.bulk_ct } };
+            //Neighbors along the seam, which only the diagonals (and the hex lattice's rows) reach
+            auto const reach{ [across, y{ rhs.y }](std::size_t index) -> std::pair<int, int>
+                {
+                    if constexpr (connectivity::four == conn)
+                        return { 0, 0 };
+                    else if constexpr (connectivity::eight == conn)
+                        return { -1, 1 };
+                    else if (across)
+                        //Cells in even rows reach back a column into the rows above and below
+                        return (y + index) % 2 ? std::pair{ 0, 0 } : std::pair{ -1, 1 };
+                    else
+                        //Even rows touch above-left, odd rows above-right
+                        return y % 2 ? std::pair{ 0, 1 } : std::pair{ -1, 0 };
+                } };
+            if (across)
+            {
+                zip(known, lhs.right, rhs.left, reach);
+                retval.top = std::move(lhs.top);
+                append(retval.top, rhs.top);
+                retval.bottom = std::move(lhs.bottom);
+                append(retval.bottom, rhs.bottom);
+                retval.left = std::move(lhs.left);
+                retval.right = std::move(rhs.right);
+            }
+            else
+            {
+                zip(known, lhs.bottom, rhs.top, reach);
+                retval.left = std::move(lhs.left);
+                append(retval.left, rhs.left);
+                retval.right = std::move(lhs.right);
+                append(retval.right, rhs.right);
+                retval.top = std::move(lhs.top);
+                retval.bottom = std::move(rhs.bottom);
+            }
+            normalize(retval, known, scratch);
             return retval;
         }
 
-        struct solve3 : matrix<std::unique_ptr<bool[]>>
+        //solve2 over 2D tiles rather than rows: each leaf is a tile labeled by solve's row scan, and is
+        //summarized by the ids along all four of its sides, so summaries merge side by side as well as
+        //top to bottom
+        //Coordinates are the grid's, of which the input is the block with its top left corner at (x0, y0)
+        template<connectivity conn = connectivity::four>
+        class tiled
         {
-            void swarm_launch(std::size_t x, std::size_t y)
+            bool const *const origin;
+            lin_alg3::slice_axis const wt, ht;
+            std::size_t const x0, y0, grid_width, side;
+            tree known;
+            relabel_scratch scratch;
+            std::unique_ptr<tree::node[]> prevline, curline;
+
+            [[nodiscard]] summary leaf(std::size_t x, std::size_t y, std::size_t width, std::size_t height)
             {
-                if (auto & cur_loc{ data[coords[{x, y}].to_scalar()] })
+                summary retval{ .conn{ conn }, .x{ x }, .y{ y }, .width{ width }, .height{ height } };
+                auto const open_left{ 0 != x }, open_right{ grid_width != x + width };
+                retval.left.resize(open_left ? height : 0);
+                retval.right.resize(open_right ? height : 0);
+                known.clear();
+                std::fill_n(prevline.get(), width, blank);
+                for (std::size_t index{ 0 }; index < height; ++index)
                 {
-                    cur_loc = false;
-                    std::ptrdiff_t dx, dy;
-                    for (auto const coord : {&dx, &dy})
-                        for (auto const dir : {-1, 1})
+                    auto const row{ origin + static_cast<std::ptrdiff_t>(x - x0) * wt.stride +
+                        static_cast<std::ptrdiff_t>(y - y0 + index) * ht.stride };
+                    auto const sweep{ [&](auto const &cell)
                         {
-                            dx = dy = 0;
-                            *coord = dir;
-                            swarm_launch(x + dx, y + dy);
+                            scan_row<conn>(known, width, prevline.get(), curline.get(), cell, (y + index) % 2);
+                        } };
+                    if (1 == wt.stride)
+                        sweep([row](std::size_t jndex) { return row[jndex]; });
+                    else
+                        sweep([row, stride{ wt.stride }](std::size_t jndex)
+                            { return row[static_cast<std::ptrdiff_t>(jndex) * stride]; });
+                    if (open_left)
+                        retval.left[index] = curline[0];
+                    if (open_right)
+                        retval.right[index] = curline[width - 1];
+                    if (!index)
+                        retval.top.assign(curline.get(), curline.get() + width);
+                    std::swap(prevline, curline);
+                }
+                retval.bottom.assign(prevline.get(), prevline.get() + width);
+                normalize(retval, known, scratch);
+                return retval;
+            }
+            //Split the longer side at a tile boundary, until down to a single tile
+            [[nodiscard]] summary region(std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+            {
+                auto const across{ width > side && (width >= height || height <= side) };
+                if (!across && height <= side)
+                    return leaf(x, y, width, height);
+                auto const &len{ across ? width : height };
+                auto const split{ (len + side - 1) / side / 2 * side };
+                if (across)
+                    return merge<conn>(region(x, y, split, height), region(x + split, y, width - split, height),
+                        true, known, scratch);
+                return merge<conn>(region(x, y, width, split), region(x, y + split, width, height - split),
+                    false, known, scratch);
+            }
+        public:
+            tiled(matrix<bool const *> const &input, std::size_t side, std::size_t x0 = 0, std::size_t y0 = 0,
+                std::size_t grid_width = 0) :
+                origin{ input.data + input.coords.start },
+                wt{ input.coords.width() }, ht{ input.coords.height() },
+                x0{ x0 }, y0{ y0 }, grid_width{ grid_width ? grid_width : x0 + wt.len },
+                side{ std::max<std::size_t>(side, 1) },
+                prevline{ std::make_unique_for_overwrite<tree::node[]>(std::min(this->side, wt.len)) },
+                curline{ std::make_unique_for_overwrite<tree::node[]>(std::min(this->side, wt.len)) }
+            {
+                assert(x0 + wt.len <= this->grid_width);
+            }
+            [[nodiscard]] summary summarize(void)
+            {
+                if (!wt.len || !ht.len)
+                    return { .conn{ conn }, .x{ x0 }, .y{ y0 } };
+                return region(x0, y0, wt.len, ht.len);
+            }
+            [[nodiscard]] std::size_t operator()(void) { return summarize().count(); }
+        };
+    }
+
+    //Tiled solve2: leaves are side x side tiles (64K cells by default, to stay in cache), merged along
+    //whichever axis is longer
+    template<connectivity conn = connectivity::four>
+    [[nodiscard]] std::size_t solve2_tiled(matrix<bool const *> const &input, std::size_t side = 256)
+    {
+        return _internal::tiled<conn>{ input, side }();
+    }
+
+    //Summary of a block of a larger grid, grid_width cells wide, with the block's top left corner at
+    //(x, y); blocks summarized one at a time (say, bands of rows read from disk) merge into the whole
+    template<connectivity conn = connectivity::four>
+    [[nodiscard]] summary summarize(matrix<bool const *> const &block, std::size_t x, std::size_t y,
+        std::size_t grid_width, std::size_t side = 256)
+    {
+        return _internal::tiled<conn>{ block, side, x, y, grid_width }.summarize();
+    }
+
+    //Summary of two blocks of the same grid, rhs either just right of lhs with the same rows, or just
+    //below it with the same columns; an empty summary (the default) merges with anything as a no-op
+    [[nodiscard]] summary merge(summary lhs, summary rhs)
+    {
+        if (!lhs.width || !lhs.height)
+            return rhs;
+        if (!rhs.width || !rhs.height)
+            return lhs;
+        if (lhs.conn != rhs.conn)
+            throw std::invalid_argument("Can't merge summaries of different connectivities");
+        auto const across{ lhs.x + lhs.width == rhs.x && lhs.y == rhs.y && lhs.height == rhs.height };
+        if (!across && !(lhs.y + lhs.height == rhs.y && lhs.x == rhs.x && lhs.width == rhs.width))
+            throw std::invalid_argument("Summaries aren't of neighboring blocks");
+        if (across && (lhs.right.empty() || rhs.left.empty()))
+            throw std::invalid_argument("Summaries meet across the grid's edge");
+        if (lhs.count() > std::numeric_limits<std::size_t>::max() - rhs.count())
+            throw std::overflow_error("Too many islands to count");
+        thread_local _internal::tree known;
+        thread_local _internal::relabel_scratch scratch;
+        switch (lhs.conn)
+        {
+        case connectivity::four:
+            return _internal::merge<connectivity::four>(std::move(lhs), std::move(rhs), across, known, scratch);
+        case connectivity::eight:
+            return _internal::merge<connectivity::eight>(std::move(lhs), std::move(rhs), across, known, scratch);
+        default:
+            return _internal::merge<connectivity::hex>(std::move(lhs), std::move(rhs), across, known, scratch);
+        }
+    }
+
+    namespace _internal
+    {
+        //Scanline flood fill: each step fills a whole horizontal span of land, then queues the start
+        //of every span it touches in the rows above and below
+        //The queue is an explicit stack, so a big island can't overflow the call stack, and visited
+        //cells go in a bitset, so the input is read in place without copying or padding
+        template<connectivity conn = connectivity::four>
+        class solve3
+        {
+            struct seed
+            {
+                std::size_t x, y;
+            };
+            bool const *const data;
+            lin_alg3::slice_axis const wt, ht;
+            std::size_t const pitch; //Words per row of visited
+            std::unique_ptr<packed_word[]> const visited;
+            std::vector<seed> pending;
+
+            //A 1 not yet claimed by any island
+            [[nodiscard]] bool land(std::size_t x, std::size_t y) const noexcept
+            {
+                return data[static_cast<std::ptrdiff_t>(x) * wt.stride + static_cast<std::ptrdiff_t>(y) * ht.stride] &&
+                    !(visited[y * pitch + x / word_bits] >> x % word_bits & 1);
+            }
+            //Marks [left, right) of row y visited, a word at a time
+            void claim(std::size_t left, std::size_t right, std::size_t y) noexcept
+            {
+                auto const row{ visited.get() + y * pitch };
+                while (left < right)
+                {
+                    auto const bit{ left % word_bits },
+                        count{ std::min(right - left, word_bits - bit) };
+                    row[left / word_bits] |= ~packed_word{ 0 } >> (word_bits - count) << bit;
+                    left += count;
+                }
+            }
+            void fill(std::size_t x, std::size_t y)
+            {
+                pending.push_back({ x, y });
+                while (!pending.empty())
+                {
+                    auto const cur{ pending.back() };
+                    pending.pop_back();
+                    if (!land(cur.x, cur.y))
+                        //Another span got here first
+                        continue;
+                    auto left{ cur.x }, right{ cur.x + 1 };
+                    while (left && land(left - 1, cur.y))
+                        --left;
+                    while (right < wt.len && land(right, cur.y))
+                        ++right;
+                    claim(left, right, cur.y);
+                    //Cells of the adjacent rows that touch [left, right)
+                    auto lo{ left }, hi{ right };
+                    if constexpr (connectivity::eight == conn)
+                    {
+                        lo -= !!lo;
+                        hi += hi < wt.len;
+                    }
+                    else if constexpr (connectivity::hex == conn)
+                    {
+                        //Even rows touch the cell below-left (and above-left); odd rows below-right
+                        if (cur.y % 2)
+                            hi += hi < wt.len;
+                        else
+                            lo -= !!lo;
+                    }
+                    //Unsigned wraparound takes care of the top edge
+                    for (auto const row : { cur.y - 1, cur.y + 1 })
+                        if (row < ht.len)
+                        {
+                            auto in_span{ false };
+                            for (auto col{ lo }; col < hi; ++col)
+                                if (!land(col, row))
+                                    in_span = false;
+                                else if (!in_span)
+                                {
+                                    in_span = true;
+                                    pending.push_back({ col, row });
+                                }
                         }
                 }
             }
-            [[nodiscard]] auto operator()(void)
+        public:
+            explicit solve3(matrix<bool const *> const &input) :
+                data{ input.data + input.coords.start },
+                wt{ input.coords.width() }, ht{ input.coords.height() },
+                pitch{ words_for(wt.len) },
+                visited{ std::make_unique<packed_word[]>(pitch * ht.len) }
+            {}
+            [[nodiscard]] std::size_t operator()(void)
             {
                 std::size_t count{ 0 };
-                for (std::size_t index{ 0 }; index < coords.width().len; ++index)
-                    for (std::size_t jndex{ 0 }; jndex < coords.height().len; ++jndex)
-                        if (data[coords[{index, jndex}].to_scalar()])
+                for (std::size_t index{ 0 }; index < ht.len; ++index)
+                    for (std::size_t jndex{ 0 }; jndex < wt.len; ++jndex)
+                        if (land(jndex, index))
                         {
                             ++count;
-                            swarm_launch(index, jndex);
+                            fill(jndex, index);
                         }
                 return count;
             }
         };
     }
 
+    template<connectivity conn = connectivity::four>
     [[nodiscard]] std::size_t solve3(matrix<bool const *> const &input)
     {
-        return _internal::solve3{_internal::emplace_zeros(input)}();
+        return _internal::solve3<conn>{ input }();
+    }
+
+    namespace _internal
+    {
+        //Index of the first cell in [from, len) equal to value, or len if none
+        [[nodiscard]] std::size_t find_cell(bool const *row, std::ptrdiff_t stride,
+            std::size_t from, std::size_t len, bool value)
+        {
+            if (1 == stride)
+                //Contiguous: let the library vectorize the scan
+                return std::find(row + from, row + len, value) - row;
+            for (; from < len && value != row[from * stride]; ++from);
+            return from;
+        }
+    }
+
+    namespace _internal
+    {
+        template<typename record_t>
+        void sweep_runs(matrix<bool const *> const &input, run_merger<record_t> &runs)
+        {
+            auto const &wt{ input.coords.width() }, &ht{ input.coords.height() };
+            auto row{ input.data + input.coords.start };
+            for (std::size_t index{ 0 }; index < ht.len; ++index, row += ht.stride)
+            {
+                for (auto start{ find_cell(row, wt.stride, 0, wt.len, true) };
+                    start < wt.len;
+                    start = find_cell(row, wt.stride, start, wt.len, true))
+                {
+                    auto const stop{ find_cell(row, wt.stride, start, wt.len, false) };
+                    runs.push(start, stop);
+                    start = stop;
+                }
+                runs.next_row();
+            }
+        }
+    }
+
+    //Run-length engine: same sweep as solve, but labels runs of 1s instead of cells
+    [[nodiscard]] std::size_t solve4(matrix<bool const *> const &input)
+    {
+        _internal::run_merger<> runs;
+        _internal::sweep_runs(input, runs);
+        return runs.count();
+    }
+
+    namespace _internal
+    {
+        //Grids packed side by side by solve_batch
+        constexpr std::size_t const batch_group{ 8 };
+    }
+
+    //Scratch space for solve_batch
+    //Every buffer keeps its storage from one grid (and one call) to the next, so once an arena has
+    //warmed up, a steady stream of small grids doesn't touch the heap at all
+    class batch_arena
+    {
+        friend void solve_batch(std::span<matrix<bool const *> const>, std::span<std::size_t>, batch_arena &);
+        _internal::run_merger<> runs;
+        //A word per row for each of a group of grids, interleaved: row-major, grid fastest
+        std::vector<packed_word> rows, starts, stops;
+    };
+
+    //counts[index] gets the island count of grids[index]
+    //Grids of one shape no wider than a word go batch_group at a time: each row is packed into a
+    //word, run boundaries come from shifting those words, and each grid's runs are then merged in
+    //turn; anything else goes through the run-length engine a grid at a time
+    void solve_batch(std::span<matrix<bool const *> const> grids, std::span<std::size_t> counts,
+        batch_arena &arena)
+    {
+        using namespace _internal;
+        assert(counts.size() >= grids.size());
+        auto &runs{ arena.runs };
+        if (grids.empty())
+            return;
+        auto const &wt{ grids.front().coords.width().len }, &ht{ grids.front().coords.height().len };
+        if (wt > word_bits || !std::ranges::all_of(grids, [&](matrix<bool const *> const &grid)
+            { return wt == grid.coords.width().len && ht == grid.coords.height().len; }))
+        {
+            for (std::size_t index{ 0 }; index < grids.size(); ++index)
+            {
+                runs.clear();
+                sweep_runs(grids[index], runs);
+                counts[index] = runs.count();
+            }
+            return;
+        }
+        auto const words{ ht * batch_group };
+        for (auto const buffer : { &arena.rows, &arena.starts, &arena.stops })
+            buffer->resize(words);
+        for (std::size_t first{ 0 }; first < grids.size(); first += batch_group)
+        {
+            auto const filled{ std::min(batch_group, grids.size() - first) };
+            //Column jndex goes in bit jndex
+            for (std::size_t slot{ 0 }; slot < filled; ++slot)
+            {
+                auto const &grid{ grids[first + slot] };
+                auto const &stride{ grid.coords.width().stride };
+                auto row{ grid.data + grid.coords.start };
+                for (std::size_t index{ 0 }; index < ht; ++index, row += grid.coords.height().stride)
+                {
+                    packed_word bits{ 0 };
+                    for (std::size_t jndex{ 0 }; jndex < wt; ++jndex)
+                        bits |= packed_word{ row[static_cast<std::ptrdiff_t>(jndex) * stride] } << jndex;
+                    arena.rows[index * batch_group + slot] = bits;
+                }
+            }
+            //First and last column of every run in the group
+            for (std::size_t index{ 0 }; index < words; ++index)
+            {
+                auto const bits{ arena.rows[index] };
+                arena.starts[index] = bits & ~(bits << 1);
+                arena.stops[index] = bits & ~(bits >> 1);
+            }
+            for (std::size_t slot{ 0 }; slot < filled; ++slot)
+            {
+                runs.clear();
+                for (auto index{ slot }; index < words; index += batch_group)
+                {
+                    //Runs pair up in order: the nth start with the nth stop
+                    for (auto start{ arena.starts[index] }, stop{ arena.stops[index] }; start;
+                        start &= start - 1, stop &= stop - 1)
+                        runs.push(static_cast<std::size_t>(std::countr_zero(start)),
+                            static_cast<std::size_t>(std::countr_zero(stop)) + 1);
+                    runs.next_row();
+                }
+                counts[first + slot] = runs.count();
+            }
+        }
+    }
+
+    //One-off batch, with its own arena; keep a batch_arena around instead to reuse it across calls
+    [[nodiscard]] std::vector<std::size_t> solve_batch(std::span<matrix<bool const *> const> grids)
+    {
+        batch_arena arena;
+        std::vector<std::size_t> retval(grids.size());
+        solve_batch(grids, retval, arena);
+        return retval;
+    }
+
+    //Per-island records for solve_stats
+    //Each is a monoid: add_run folds in one run of 1s, and fold merges two islands' records
+    //Just the area, for callers that only want the size histogram
+    struct island_area
+    {
+        std::size_t area{ 0 };
+        void add_run(std::size_t, std::size_t start, std::size_t stop, std::size_t) noexcept
+        {
+            area += stop - start;
+        }
+        void fold(island_area const &other) noexcept { area += other.area; }
+    };
+
+    struct island_stats
+    {
+        std::size_t area{ 0 };
+        //Unit edges between the island and 0s or the grid's edge
+        std::size_t perimeter{ 0 };
+        //Bounding box, [left, right) x [top, bottom)
+        std::size_t left{ std::numeric_limits<std::size_t>::max() }, right{ 0 },
+            top{ std::numeric_limits<std::size_t>::max() }, bottom{ 0 };
+        //Sums of the cells' coordinates, for the centroid
+        std::size_t sum_x{ 0 }, sum_y{ 0 };
+
+        //overlap is how many of the run's cells have a 1 directly above
+        void add_run(std::size_t row, std::size_t start, std::size_t stop, std::size_t overlap) noexcept
+        {
+            auto const len{ stop - start };
+            area += len;
+            //Each cell has 4 edges; each adjacent pair of 1s hides 2
+            perimeter += 4 * len - 2 * (len - 1) - 2 * overlap;
+            left = std::min(left, start);
+            right = std::max(right, stop);
+            top = std::min(top, row);
+            bottom = std::max(bottom, row + 1);
+            sum_x += (start + stop - 1) * len / 2;
+            sum_y += row * len;
+        }
+        void fold(island_stats const &other) noexcept
+        {
+            area += other.area;
+            perimeter += other.perimeter;
+            left = std::min(left, other.left);
+            right = std::max(right, other.right);
+            top = std::min(top, other.top);
+            bottom = std::max(bottom, other.bottom);
+            sum_x += other.sum_x;
+            sum_y += other.sum_y;
+        }
+        [[nodiscard]] double centroid_x(void) const noexcept { return static_cast<double>(sum_x) / area; }
+        [[nodiscard]] double centroid_y(void) const noexcept { return static_cast<double>(sum_y) / area; }
+    };
+
+    //One pass of the run-length engine, returning a record per island instead of just the count
+    template<typename record_t = island_stats>
+    [[nodiscard]] std::vector<record_t> solve_stats(matrix<bool const *> const &input)
+    {
+        _internal::run_merger<record_t> runs;
+        _internal::sweep_runs(input, runs);
+        return runs.take_records();
+    }
+
+    //Where count_islands switches engines; the defaults are from a desktop, and calibrate measures
+    //them for the machine it runs on
+    struct dispatch_thresholds
+    {
+        static constexpr std::uint32_t const version{ 1 };
+        //Grids with fewer cells than this go straight to solve; larger ones are tiled, unless too sparse
+        //or dense for it to pay
+        std::size_t tile_cells{ std::size_t{ 1 } << 18 };
+        //Sampled densities at or below sparse, or at or above dense, are left to solve
+        double sparse{ 0.15 }, dense{ 0.9 };
+        //Sampled densities at or above this go to the run-length engine, where its rows are contiguous
+        double runs{ 0.85 };
+        //Cells read to estimate the density
+        std::size_t sample_cells{ 256 };
+
+        //One "name value" line per field, after a header line
+        void write(std::ostream &dest) const
+        {
+            dest << "islands-dispatch " << version << '\n' << "tile_cells " << tile_cells << '\n' <<
+                "sparse " << sparse << '\n' << "dense " << dense << '\n' << "runs " << runs << '\n' <<
+                "sample_cells " << sample_cells << '\n';
+        }
+        [[nodiscard]] static dispatch_thresholds read(std::istream &src)
+        {
+            std::string name;
+            std::uint32_t found;
+            if (!(src >> name >> found) || "islands-dispatch" != name)
+                throw std::runtime_error("Not a set of dispatch thresholds");
+            if (version != found)
+                throw std::runtime_error("Unsupported dispatch thresholds version " + std::to_string(found));
+            dispatch_thresholds retval;
+            //Digits only: >> would take a leading minus and wrap it around
+            auto const count{ [&src, &name](std::size_t &dest)
+                {
+                    std::string digits;
+                    src >> digits;
+                    if (digits.empty() || !std::ranges::all_of(digits, [](char c) { return '0' <= c && c <= '9'; }))
+                        src.setstate(std::ios_base::failbit);
+                    else
+                        try
+                        {
+                            dest = std::stoull(digits);
+                        }
+                        catch (std::out_of_range const &)
+                        {
+                            throw std::runtime_error("Bad value for dispatch threshold " + name);
+                        }
+                } };
+            while (src >> name)
+            {
+                if ("tile_cells" == name)
+                    count(retval.tile_cells);
+                else if ("sparse" == name)
+                    src >> retval.sparse;
+                else if ("dense" == name)
+                    src >> retval.dense;
+                else if ("runs" == name)
+                    src >> retval.runs;
+                else if ("sample_cells" == name)
+                    count(retval.sample_cells);
+                else
+                    throw std::runtime_error("Unknown dispatch threshold " + name);
+                if (!src)
+                    throw std::runtime_error("Bad value for dispatch threshold " + name);
+            }
+            //The comparisons are written so NaN fails them too
+            auto const fraction{ [](double value) { return 0 <= value && value <= 1; } };
+            if (!fraction(retval.sparse) || !fraction(retval.dense) || !fraction(retval.runs) ||
+                !(retval.sparse <= retval.dense))
+                throw std::runtime_error("Dispatch densities out of range");
+            return retval;
+        }
+    };
+
+    //What count_islands goes by when not handed thresholds; calibrate replaces them, so calibrate
+    //before counting on other threads
+    [[nodiscard]] dispatch_thresholds &current_thresholds(void) noexcept
+    {
+        static dispatch_thresholds retval;
+        return retval;
+    }
+
+    //Replaces current_thresholds with ones saved by write (Benchmark --calibrate=FILE, say), so
+    //count_islands goes by them from then on; the same caveat about other threads as calibrate
+    dispatch_thresholds const &load_thresholds(std::filesystem::path const &path)
+    {
+        std::ifstream src(path);
+        if (!src)
+            throw std::runtime_error("Can't open dispatch thresholds " + path.string());
+        return current_thresholds() = dispatch_thresholds::read(src);
+    }
+
+    enum class engine { solve, solve2_tiled, solve4 };
+
+    namespace _internal
+    {
+        //Fraction of land among count cells spread evenly through the grid in row-major order
+        [[nodiscard]] double sample_density(matrix<bool const *> const &input, std::size_t count) noexcept
+        {
+            auto const &wt{ input.coords.width() }, &ht{ input.coords.height() };
+            auto const cells{ wt.len * ht.len };
+            auto const origin{ input.data + input.coords.start };
+            count = std::min(std::max<std::size_t>(count, 1), cells);
+            std::size_t land{ 0 };
+            for (std::size_t index{ 0 }; index < count; ++index)
+            {
+                auto const cell{ index * cells / count };
+                land += origin[static_cast<std::ptrdiff_t>(cell / wt.len) * ht.stride +
+                    static_cast<std::ptrdiff_t>(cell % wt.len) * wt.stride];
+            }
+            return static_cast<double>(land) / count;
+        }
+    }
+
+    //Which engine count_islands would run: solve for small grids and for very sparse or dense ones,
+    //whose unions are few and cheap; the tiled solve2 for large middling ones, whose tiles stay in
+    //cache; the run-length engine for large dense ones it can scan a contiguous row at a time
+    //solve3 and the untiled solve2 are never picked: on every shape and density measured one of these
+    //three beat them
+    template<connectivity conn = connectivity::four>
+    [[nodiscard]] engine choose_engine(matrix<bool const *> const &input,
+        dispatch_thresholds const &limits = current_thresholds()) noexcept
+    {
+        auto const cells{ input.coords.width().len * input.coords.height().len };
+        //The crossovers were all measured on grids this big, so smaller ones aren't worth sampling
+        if (!cells || cells < limits.tile_cells)
+            return engine::solve;
+        auto const runs{ connectivity::four == conn && 1 == input.coords.width().stride && limits.runs <= 1 };
+        //Nothing left for the density to decide
+        if (!runs && !(limits.sparse < limits.dense))
+            return engine::solve;
+        auto const density{ _internal::sample_density(input, limits.sample_cells) };
+        if (runs && density >= limits.runs)
+            return engine::solve4;
+        if (limits.sparse < density && density < limits.dense)
+            return engine::solve2_tiled;
+        return engine::solve;
+    }
+
+    //The island count by whichever engine should be fastest on this grid
+    template<connectivity conn = connectivity::four>
+    [[nodiscard]] std::size_t count_islands(matrix<bool const *> const &input,
+        dispatch_thresholds const &limits = current_thresholds())
+    {
+        switch (choose_engine<conn>(input, limits))
+        {
+        case engine::solve2_tiled:
+            return solve2_tiled<conn>(input);
+        case engine::solve4:
+            if constexpr (connectivity::four == conn)
+                return solve4(input);
+            [[fallthrough]];
+        default:
+            return solve<conn>(input);
+        }
+    }
+
+    //Times the engines against each other on random square grids and sets current_thresholds to
+    //where they cross: the smallest side (64 up to 2048) from which on up tiling beats solve at
+    //density 0.5 (or 1024, with tiling off, if it never does); then, on grids that size (or 1024
+    //square, if smaller), the densities either side of 0.5 at which it stops beating solve, and the
+    //lowest from which on up the run-length engine beats both
+    //Best of reps samples each; a few seconds, all told
+    dispatch_thresholds calibrate(std::uint64_t seed = 20210525, std::size_t reps = 3)
+    {
+        dispatch_thresholds retval{ current_thresholds() };
+        std::mt19937_64 rng(seed);
+        std::vector<char> cells;
+        //Small grids come a million cells or so at a time, each different, lest the branch
+        //predictors learn one by heart
+        std::vector<matrix<bool const *>> grids;
+        auto const fill{ [&](std::size_t side, double p)
+            {
+                std::bernoulli_distribution land(p);
+                auto const count{ std::max<std::size_t>((std::size_t{ 1 } << 20) / (side * side), 1) };
+                cells.resize(count * side * side);
+                for (auto &cell : cells)
+                    cell = land(rng);
+                grids.clear();
+                for (std::size_t index{ 0 }; index < count; ++index)
+                    grids.push_back({ matrix_slice(side, side),
+                        reinterpret_cast<bool const *>(cells.data()) + index * side * side });
+            } };
+        typedef std::size_t(*engine_t)(matrix<bool const *> const &);
+        //After a run to warm up; every count goes into found, which is checked at the end, so none of
+        //the runs can be optimized away
+        std::size_t found{ 0 };
+        auto const time{ [&grids, &found, reps](engine_t func)
+            {
+                found += (*func)(grids.front());
+                auto best{ std::chrono::steady_clock::duration::max() };
+                for (std::size_t count{ 0 }; count < std::max<std::size_t>(reps, 1); ++count)
+                {
+                    auto const start{ std::chrono::steady_clock::now() };
+                    for (auto const &input : grids)
+                        found += (*func)(input);
+                    best = std::min(best, std::chrono::steady_clock::now() - start);
+                }
+                return best;
+            } };
+        engine_t const plain{ &solve }, tiled{ [](matrix<bool const *> const &input) { return solve2_tiled(input); } },
+            runs{ &solve4 };
+        //Walking down from the top until solve wins
+        auto side{ std::numeric_limits<std::size_t>::max() };
+        for (std::size_t trial{ 2048 }; trial >= 64; trial /= 2)
+            if (fill(trial, 0.5); time(tiled) < time(plain))
+                side = trial;
+            else
+                break;
+        double const densities[]{ 0.05, 0.1, 0.15, 0.2, 0.25, 0.3, 0.35, 0.4, 0.45, 0.5,
+            0.55, 0.6, 0.65, 0.7, 0.75, 0.8, 0.85, 0.9, 0.95 };
+        auto const middle{ std::ranges::find(densities, 0.5) };
+        if (std::numeric_limits<std::size_t>::max() != side)
+        {
+            retval.tile_cells = side * side;
+            retval.sparse = 0, retval.dense = 1;
+            side = std::min<std::size_t>(side, 1024);
+            //Walking out from 0.5 until solve wins
+            for (auto p{ middle }; p != std::ranges::begin(densities); )
+                if (fill(side, *--p); time(plain) <= time(tiled))
+                {
+                    retval.sparse = *p;
+                    break;
+                }
+            for (auto p{ middle + 1 }; p != std::ranges::end(densities); ++p)
+                if (fill(side, *p); time(plain) <= time(tiled))
+                {
+                    retval.dense = *p;
+                    break;
+                }
+        }
+        else
+        {
+            //Only the run-length engine is left to pick, on grids the size it's timed on
+            side = 1024;
+            retval.tile_cells = side * side;
+            retval.sparse = retval.dense = 0.5;
+        }
+        //Walking down from the top until the run-length engine loses
+        retval.runs = 1;
+        for (auto p{ std::ranges::end(densities) }; p != std::ranges::begin(densities); )
+            if (fill(side, *--p); time(runs) < std::min(time(plain), time(tiled)))
+                retval.runs = *p;
+            else
+                break;
+        //Random grids of density 0.05 and up can't all be water
+        if (!found)
+            throw std::logic_error("Engines found no islands while calibrating");
+        return current_thresholds() = retval;
     }
 }
\ No newline at end of file
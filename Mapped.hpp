@@ -0,0 +1,359 @@
+#pragma once
+#include <cstddef>
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Islands.hpp"
+
+namespace mapped
+{
+    //Read-only mapping of a whole file; pages come in as the solvers touch them
+    class file_view
+    {
+        std::byte const *base{ nullptr };
+        std::size_t len{ 0 };
+#ifdef _WIN32
+        HANDLE file{ INVALID_HANDLE_VALUE }, mapping{ nullptr };
+#endif
+        void release(void) noexcept
+        {
+#ifdef _WIN32
+            if (base)
+                UnmapViewOfFile(base);
+            if (mapping)
+                CloseHandle(mapping);
+            if (INVALID_HANDLE_VALUE != file)
+                CloseHandle(file);
+#else
+            if (base)
+                munmap(const_cast<std::byte *>(base), len);
+#endif
+        }
+    public:
+        explicit file_view(std::filesystem::path const &path)
+        {
+#ifdef _WIN32
+            file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (INVALID_HANDLE_VALUE == file)
+                throw std::system_error(GetLastError(), std::system_category(), "CreateFile");
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size))
+            {
+                auto const error{ GetLastError() };
+                release();
+                throw std::system_error(error, std::system_category(), "GetFileSizeEx");
+            }
+            len = static_cast<std::size_t>(size.QuadPart);
+            //Can't map an empty file
+            if (!len)
+                return;
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping)
+                base = static_cast<std::byte const *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (!base)
+            {
+                auto const error{ GetLastError() };
+                release();
+                throw std::system_error(error, std::system_category(), "MapViewOfFile");
+            }
+#else
+            auto const fd{ open(path.c_str(), O_RDONLY) };
+            if (fd < 0)
+                throw std::system_error(errno, std::generic_category(), "open");
+            struct stat info;
+            if (fstat(fd, &info))
+            {
+                auto const error{ errno };
+                close(fd);
+                throw std::system_error(error, std::generic_category(), "fstat");
+            }
+            len = static_cast<std::size_t>(info.st_size);
+            void *addr{ nullptr };
+            //Can't map an empty file
+            if (len)
+                addr = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            auto const error{ errno };
+            //The mapping holds its own reference to the file
+            close(fd);
+            if (MAP_FAILED == addr)
+                throw std::system_error(error, std::generic_category(), "mmap");
+            base = static_cast<std::byte const *>(addr);
+            if (base)
+                madvise(addr, len, MADV_SEQUENTIAL);
+#endif
+        }
+        file_view(file_view &&other) noexcept :
+            base{ std::exchange(other.base, nullptr) }, len{ std::exchange(other.len, 0) }
+#ifdef _WIN32
+            , file{ std::exchange(other.file, INVALID_HANDLE_VALUE) },
+            mapping{ std::exchange(other.mapping, nullptr) }
+#endif
+        {}
+        file_view &operator=(file_view &&other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                base = std::exchange(other.base, nullptr);
+                len = std::exchange(other.len, 0);
+#ifdef _WIN32
+                file = std::exchange(other.file, INVALID_HANDLE_VALUE);
+                mapping = std::exchange(other.mapping, nullptr);
+#endif
+            }
+            return *this;
+        }
+        ~file_view(void) noexcept { release(); }
+        [[nodiscard]] std::span<std::byte const> bytes(void) const noexcept { return { base, len }; }
+    };
+
+    //Read-write mapping of a new file of len bytes, replacing any old one there; what's written
+    //reaches the file as the OS pages it out, and all of it by the time the mapping goes away
+    class output_file
+    {
+        std::byte *base{ nullptr };
+        std::size_t len{ 0 };
+#ifdef _WIN32
+        HANDLE file{ INVALID_HANDLE_VALUE }, mapping{ nullptr };
+#endif
+        void release(void) noexcept
+        {
+#ifdef _WIN32
+            if (base)
+                UnmapViewOfFile(base);
+            if (mapping)
+                CloseHandle(mapping);
+            if (INVALID_HANDLE_VALUE != file)
+                CloseHandle(file);
+#else
+            if (base)
+                munmap(base, len);
+#endif
+        }
+    public:
+        output_file(std::filesystem::path const &path, std::size_t len) : len{ len }
+        {
+#ifdef _WIN32
+            file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (INVALID_HANDLE_VALUE == file)
+                throw std::system_error(GetLastError(), std::system_category(), "CreateFile");
+            //Can't map an empty file
+            if (!len)
+                return;
+            //Mapping past the end grows the file to fit
+            auto const size{ static_cast<std::uint64_t>(len) };
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE,
+                static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+            if (mapping)
+                base = static_cast<std::byte *>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+            if (!base)
+            {
+                auto const error{ GetLastError() };
+                release();
+                throw std::system_error(error, std::system_category(), "MapViewOfFile");
+            }
+#else
+            auto const fd{ open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666) };
+            if (fd < 0)
+                throw std::system_error(errno, std::generic_category(), "open");
+            if (ftruncate(fd, static_cast<off_t>(len)))
+            {
+                auto const error{ errno };
+                close(fd);
+                throw std::system_error(error, std::generic_category(), "ftruncate");
+            }
+            void *addr{ nullptr };
+            //Can't map an empty file
+            if (len)
+                addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            auto const error{ errno };
+            //The mapping holds its own reference to the file
+            close(fd);
+            if (MAP_FAILED == addr)
+                throw std::system_error(error, std::generic_category(), "mmap");
+            base = static_cast<std::byte *>(addr);
+            if (base)
+                madvise(addr, len, MADV_SEQUENTIAL);
+#endif
+        }
+        output_file(output_file &&other) noexcept :
+            base{ std::exchange(other.base, nullptr) }, len{ std::exchange(other.len, 0) }
+#ifdef _WIN32
+            , file{ std::exchange(other.file, INVALID_HANDLE_VALUE) },
+            mapping{ std::exchange(other.mapping, nullptr) }
+#endif
+        {}
+        output_file &operator=(output_file &&other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                base = std::exchange(other.base, nullptr);
+                len = std::exchange(other.len, 0);
+#ifdef _WIN32
+                file = std::exchange(other.file, INVALID_HANDLE_VALUE);
+                mapping = std::exchange(other.mapping, nullptr);
+#endif
+            }
+            return *this;
+        }
+        ~output_file(void) noexcept { release(); }
+        [[nodiscard]] std::span<std::byte> bytes(void) const noexcept { return { base, len }; }
+    };
+
+    namespace _internal
+    {
+        //Netpbm header token, skipping whitespace and comments; pos ends just past the token
+        [[nodiscard]] std::size_t pbm_token(std::span<std::byte const> bytes, std::size_t &pos)
+        {
+            auto const at{ [&](std::size_t index) { return static_cast<char>(bytes[index]); } };
+            auto const is_space{ [](char c) { return ' ' == c || '\t' == c || '\n' == c || '\r' == c ||
+                '\v' == c || '\f' == c; } };
+            for (; pos < bytes.size(); ++pos)
+                if ('#' == at(pos))
+                    while (pos < bytes.size() && '\n' != at(pos))
+                        ++pos;
+                else if (!is_space(at(pos)))
+                    break;
+            std::size_t retval{ 0 }, digits{ 0 };
+            for (; pos < bytes.size() && '0' <= at(pos) && at(pos) <= '9'; ++pos, ++digits)
+            {
+                auto const digit{ static_cast<std::size_t>(at(pos) - '0') };
+                if (retval > (std::numeric_limits<std::size_t>::max() - digit) / 10)
+                    throw std::runtime_error("PBM dimension too large");
+                retval = 10 * retval + digit;
+            }
+            if (!digits || pos >= bytes.size() || !is_space(at(pos)))
+                throw std::runtime_error("Malformed PBM header");
+            return retval;
+        }
+
+        //The dimensions come from the file or the caller, so their products can't be trusted not to wrap
+        [[nodiscard]] std::size_t product(std::size_t lhs, std::size_t rhs)
+        {
+            if (lhs && rhs > std::numeric_limits<std::size_t>::max() / lhs)
+                throw std::runtime_error("Dimensions too large");
+            return lhs * rhs;
+        }
+
+        //Bytes in a row of width bits
+        [[nodiscard]] std::size_t row_bytes(std::size_t width)
+        {
+            if (width > std::numeric_limits<std::size_t>::max() - 7)
+                throw std::runtime_error("Dimensions too large");
+            return (width + 7) / 8;
+        }
+
+        void check_size(std::span<std::byte const> bytes, std::size_t offset, std::size_t needed)
+        {
+            if (bytes.size() < offset || bytes.size() - offset < needed)
+                throw std::runtime_error("File too short for its dimensions");
+        }
+    }
+
+    //Binary PBM (P4): rows of (width + 7) / 8 bytes, most significant bit first, 1 = black
+    class pbm : public file_view
+    {
+        std::size_t width, height, offset;
+    public:
+        explicit pbm(std::filesystem::path const &path) : file_view(path)
+        {
+            auto const data{ bytes() };
+            if (data.size() < 2 || 'P' != static_cast<char>(data[0]) || '4' != static_cast<char>(data[1]))
+                throw std::runtime_error("Not a binary PBM (P4) file");
+            std::size_t pos{ 2 };
+            width = _internal::pbm_token(data, pos);
+            height = _internal::pbm_token(data, pos);
+            //Exactly one whitespace character separates the header from the raster
+            offset = pos + 1;
+            _internal::check_size(data, offset, _internal::product(_internal::row_bytes(width), height));
+        }
+        [[nodiscard]] auto view(void) const noexcept
+        {
+            return islands::packed_matrix<std::uint8_t const *, islands::bit_order::msb_first>{
+                width, height, static_cast<std::ptrdiff_t>((width + 7) / 8),
+                reinterpret_cast<std::uint8_t const *>(bytes().data() + offset)
+            };
+        }
+    };
+
+    //Headerless raster of one byte per cell, row-major
+    //Each byte must be 0 or 1, since the solvers read them in place as bools
+    class raw_bytes : public file_view
+    {
+        std::size_t width, height;
+    public:
+        raw_bytes(std::filesystem::path const &path, std::size_t width, std::size_t height) :
+            file_view(path), width{ width }, height{ height }
+        {
+            _internal::check_size(bytes(), 0, _internal::product(width, height));
+        }
+        [[nodiscard]] auto view(void) const noexcept
+        {
+            return islands::matrix<bool const *>{
+                islands::matrix_slice(width, height), reinterpret_cast<bool const *>(bytes().data())
+            };
+        }
+    };
+
+    //Headerless raster of one bit per cell, each row padded out to stride bytes
+    template<islands::bit_order order = islands::bit_order::msb_first>
+    class raw_bits : public file_view
+    {
+        std::size_t width, height, stride;
+    public:
+        raw_bits(std::filesystem::path const &path, std::size_t width, std::size_t height,
+            std::size_t stride = 0) :
+            file_view(path), width{ width }, height{ height }, stride{ stride ? stride : _internal::row_bytes(width) }
+        {
+            assert(this->stride >= _internal::row_bytes(width));
+            _internal::check_size(bytes(), 0, _internal::product(this->stride, height));
+        }
+        [[nodiscard]] auto view(void) const noexcept
+        {
+            return islands::packed_matrix<std::uint8_t const *, order>{
+                width, height, static_cast<std::ptrdiff_t>(stride),
+                reinterpret_cast<std::uint8_t const *>(bytes().data())
+            };
+        }
+    };
+
+    //Label image for islands::label: width x height cells of label_t, row-major, in native byte order
+    template<std::unsigned_integral label_t = std::uint32_t>
+    class label_map : public output_file
+    {
+    public:
+        label_map(std::filesystem::path const &path, std::size_t width, std::size_t height) :
+            output_file(path, _internal::product(_internal::product(width, height), sizeof(label_t)))
+        {}
+        [[nodiscard]] std::span<label_t> labels(void) const noexcept
+        {
+            auto const raw{ bytes() };
+            return { reinterpret_cast<label_t *>(raw.data()), raw.size() / sizeof(label_t) };
+        }
+    };
+}
\ No newline at end of file
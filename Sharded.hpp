@@ -0,0 +1,170 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "Islands.hpp"
+
+namespace sharded
+{
+    //First and one-past-last rows of band index, when height rows are dealt out as evenly as possible
+    [[nodiscard]] std::pair<std::size_t, std::size_t> band(std::size_t height, std::size_t shards,
+        std::size_t index) noexcept
+    {
+        return { height * index / shards, height * (index + 1) / shards };
+    }
+
+    //Summary of one band of rows, positioned in the whole grid so it merges with its neighbors
+    template<islands::connectivity conn = islands::connectivity::four>
+    [[nodiscard]] islands::summary summarize_band(islands::matrix<bool const *> const &input,
+        std::size_t shards, std::size_t index)
+    {
+        auto const &wt{ input.coords.width() }, &ht{ input.coords.height() };
+        auto const [first, last] { band(ht.len, shards, index) };
+        return islands::summarize<conn>({ lin_alg3::slice<2>{
+            input.coords.start + static_cast<std::ptrdiff_t>(first) * ht.stride,
+            { wt, { last - first, ht.stride } } }, input.data }, 0, first, wt.len);
+    }
+
+    //Merges neighbors pairwise, level by level, so no summary takes part in more than log2(shards) merges
+    [[nodiscard]] islands::summary reduce(std::vector<islands::summary> parts)
+    {
+        if (parts.empty())
+            return {};
+        for (std::size_t step{ 1 }; step < size(parts); step *= 2)
+            for (std::size_t index{ 0 }; index + step < size(parts); index += 2 * step)
+                parts[index] = islands::merge(std::move(parts[index]), std::move(parts[index + step]));
+        return std::move(parts.front());
+    }
+
+#ifndef _WIN32
+    //A summary in the binary format, written whole; the reader takes end of file as the end of it
+    void send(int fd, islands::summary const &soln)
+    {
+        std::ostringstream buffer;
+        soln.write(buffer);
+        auto const bytes{ std::move(buffer).str() };
+        for (std::size_t done{ 0 }; done < size(bytes); )
+            if (auto const sent{ write(fd, bytes.data() + done, size(bytes) - done) }; sent >= 0)
+                done += static_cast<std::size_t>(sent);
+            else if (EINTR != errno)
+                throw std::system_error(errno, std::generic_category(), "write");
+    }
+
+    [[nodiscard]] islands::summary receive(int fd)
+    {
+        std::string bytes;
+        char chunk[1 << 16];
+        for (;;)
+            if (auto const got{ read(fd, chunk, sizeof chunk) }; got > 0)
+                bytes.append(chunk, static_cast<std::size_t>(got));
+            else if (!got)
+                break;
+            else if (EINTR != errno)
+                throw std::system_error(errno, std::generic_category(), "read");
+        std::istringstream buffer(std::move(bytes));
+        return islands::summary::read(buffer);
+    }
+#endif
+
+    //Solves the grid a band of rows per worker process, each forked from this one so it sees the grid
+    //copy-on-write, and sending back its band's summary over a pipe for this process to reduce
+    //Call it before this process starts other threads: a forked worker gets only the calling thread, and
+    //would hang on any lock (the heap's, say) that another thread held at the fork
+    template<islands::connectivity conn = islands::connectivity::four>
+    [[nodiscard]] std::size_t solve(islands::matrix<bool const *> const &input, std::size_t shards)
+    {
+        shards = std::max<std::size_t>(shards, 1);
+        std::vector<islands::summary> parts;
+        parts.reserve(shards);
+#ifdef _WIN32
+        //No fork here: the bands are solved one after another in this process, then reduced the same way
+        for (std::size_t index{ 0 }; index < shards; ++index)
+            parts.push_back(summarize_band<conn>(input, shards, index));
+#else
+        struct worker
+        {
+            pid_t pid;
+            int fd;
+        };
+        std::vector<worker> workers;
+        workers.reserve(shards);
+        //Close whatever pipes are left and wait out every worker; true if they all succeeded
+        auto const finish{ [&workers]
+            {
+                auto retval{ true };
+                for (auto &[pid, fd] : workers)
+                {
+                    if (fd >= 0)
+                        close(fd);
+                    int status{ -1 };
+                    while (waitpid(pid, &status, 0) < 0 && EINTR == errno);
+                    retval = retval && WIFEXITED(status) && !WEXITSTATUS(status);
+                }
+                workers.clear();
+                return retval;
+            } };
+        try
+        {
+            for (std::size_t index{ 0 }; index < shards; ++index)
+            {
+                int fds[2];
+                if (pipe(fds))
+                    throw std::system_error(errno, std::generic_category(), "pipe");
+                auto const pid{ fork() };
+                if (pid < 0)
+                {
+                    auto const error{ errno };
+                    close(fds[0]);
+                    close(fds[1]);
+                    throw std::system_error(error, std::generic_category(), "fork");
+                }
+                if (!pid)
+                {
+                    close(fds[0]);
+                    //_exit, not return or exit: the parent's static destructors and atexit handlers (its
+                    //thread pools, say) aren't the worker's to run
+                    auto status{ 0 };
+                    try
+                    {
+                        send(fds[1], summarize_band<conn>(input, shards, index));
+                    }
+                    catch (...)
+                    {
+                        status = 1;
+                    }
+                    _exit(status);
+                }
+                close(fds[1]);
+                workers.push_back({ pid, fds[0] });
+            }
+            //Each worker blocks on its own pipe until read, so reading them in order can't deadlock
+            for (auto &[pid, fd] : workers)
+            {
+                parts.push_back(receive(fd));
+                close(std::exchange(fd, -1));
+            }
+        }
+        catch (...)
+        {
+            (void)finish();
+            throw;
+        }
+        if (!finish())
+            throw std::runtime_error("Shard worker failed");
+#endif
+        return reduce(std::move(parts)).count();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Tweaks.hpp"
+
+namespace tasks
+{
+    //Work-stealing thread pool
+    //Each worker pops its own queue LIFO (depth-first, so the data it just split is still in cache)
+    //and, once that runs dry, steals FIFO from the others (the oldest, hence biggest, pieces of work)
+    class pool final
+    {
+    public:
+        typedef std::function<void(void)> task;
+    private:
+        struct worker_queue
+        {
+            std::mutex lock;
+            std::deque<task> tasks;
+        };
+        std::unique_ptr<worker_queue[]> queues;
+        std::size_t const count;
+        //Tasks pushed but not yet popped; guarded by idle_lock for the sake of sleeping workers
+        std::atomic<std::size_t> queued{ 0 };
+        std::atomic<std::size_t> next_victim{ 0 };
+        std::mutex idle_lock;
+        std::condition_variable wakeup;
+        bool stopping{ false };
+        std::vector<std::jthread> threads;
+
+        //Which pool (if any) the current thread works for, and its queue there
+        inline static thread_local pool const *owner{ nullptr };
+        inline static thread_local std::size_t self{ 0 };
+
+        [[nodiscard]] bool try_pop(std::size_t index, task &dest)
+        {
+            auto &queue{ queues[index] };
+            std::lock_guard _guard{ queue.lock };
+            if (queue.tasks.empty())
+                return false;
+            dest = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+        [[nodiscard]] bool try_steal(std::size_t thief, task &dest)
+        {
+            for (auto index{ (thief + 1) % count }; index != thief; index = (index + 1) % count)
+            {
+                auto &queue{ queues[index] };
+                std::lock_guard _guard{ queue.lock };
+                if (queue.tasks.empty())
+                    continue;
+                dest = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                return true;
+            }
+            return false;
+        }
+        void work(std::size_t index)
+        {
+            owner = this;
+            self = index;
+            task cur;
+            for (;;)
+            {
+                if (try_pop(index, cur) || try_steal(index, cur))
+                {
+                    --queued;
+                    cur();
+                    cur = nullptr;
+                    continue;
+                }
+                std::unique_lock _guard{ idle_lock };
+                wakeup.wait(_guard, [this] { return stopping || queued; });
+                if (stopping && !queued)
+                    return;
+            }
+        }
+    public:
+        explicit pool(std::size_t count = std::thread::hardware_concurrency()) :
+            queues{ std::make_unique<worker_queue[]>(std::max<std::size_t>(count, 1)) },
+            count{ std::max<std::size_t>(count, 1) }
+        {
+            threads.reserve(this->count);
+            for (std::size_t index{ 0 }; index < this->count; ++index)
+                threads.emplace_back(&pool::work, this, index);
+        }
+        pool(pool const &) = delete;
+        pool &operator=(pool const &) = delete;
+        ~pool(void) noexcept
+        {
+            {
+                std::lock_guard _guard{ idle_lock };
+                stopping = true;
+            }
+            wakeup.notify_all();
+            //Workers drain their queues before exiting; jthread joins them
+            threads.clear();
+        }
+        [[nodiscard]] auto size(void) const noexcept { return count; }
+        //Tasks spawned from a worker go on its own queue; anything else is dealt out round-robin
+        void spawn(task job)
+        {
+            auto const index{ this == owner ? self : next_victim++ % count };
+            {
+                auto &queue{ queues[index] };
+                std::lock_guard _guard{ queue.lock };
+                queue.tasks.push_back(std::move(job));
+            }
+            {
+                std::lock_guard _guard{ idle_lock };
+                ++queued;
+            }
+            wakeup.notify_one();
+        }
+    };
+}
\ No newline at end of file
@@ -2,13 +2,23 @@
 #include <cassert>
 #include <cstdint>
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <numeric>
 #include <random>
+#include <span>
+#include <sstream>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -16,6 +26,9 @@
 
 #include "LinAlg3.hpp"
 #include "Islands.hpp"
+#include "Mapped.hpp"
+#include "Sharded.hpp"
+#include "Generate.hpp"
 
 #define GIANT
 //#define FUZZ_FIXED_SIZE
@@ -24,9 +37,10 @@ enum intbool : bool;
 
 namespace test
 {
-    std::default_random_engine engine(std::random_device{}()); //Use random seed, but after that anything's OK
+    thread_local std::default_random_engine engine(std::random_device{}()); //Use random seed, but after that anything's OK; the fuzzer reseeds it per grid
     std::geometric_distribution<unsigned int> sizing(0.001); //Prob is p <=> mean is 1/p-1
     std::discrete_distribution<> coin_flip({ 0.501, 0.499 }); //2D percolation is critical at 0.5
+    generate::engine grid_engine(std::random_device{}()); //Fills the fuzzed grids 64 random bits at a time, or seeds the workers that do
 
     namespace internal
     {
@@ -70,35 +84,603 @@ namespace test
         return sz;
     }
 
+    //Union-find worst case: each tooth of the comb is its own island until the bar along the bottom,
+    //and the teeth's ids decrease left to right, so linking by index without compression hangs
+    //them in one long chain that the bar walks again for every tooth
+    auto make_comb(std::size_t const teeth, islands::matrix<std::vector<intbool>> &dest)
+    {
+        assert(teeth);
+        auto const wt{ 2 * teeth - 1 }, ht{ teeth + 1 };
+        auto const sz{ resize_matrix(wt, ht, dest) };
+        std::fill_n(dest.data.begin(), sz, intbool{ false });
+        for (std::size_t tooth{ 0 }; tooth < teeth; ++tooth)
+            //Rightmost tooth starts first, so gets the least id
+            for (auto index{ teeth - 1 - tooth }; index < ht; ++index)
+                dest.data[index * wt + 2 * tooth] = intbool{ true };
+        std::fill_n(dest.data.begin() + (ht - 1) * wt, wt, intbool{ true });
+        return sz;
+    }
+
+    //One island, coiled so the row scan sees each ring as several islands that merge late
+    auto make_spiral(std::size_t const side, islands::matrix<std::vector<intbool>> &dest)
+    {
+        assert(side);
+        auto const sz{ resize_matrix(side, side, dest) };
+        std::fill_n(dest.data.begin(), sz, intbool{ false });
+        std::size_t x{ 0 }, y{ 0 };
+        std::ptrdiff_t dx{ 1 }, dy{ 0 };
+        dest.data[0] = intbool{ true };
+        //Arm lengths go n-1, n-1, n-1, n-3, n-3, n-5, n-5, ..., leaving a gap of 1 between rings
+        for (std::size_t arm{ 0 }, len{ side - 1 }; len && len < side; ++arm)
+        {
+            for (std::size_t step{ 0 }; step < len; ++step)
+                dest.data[(y += dy) * side + (x += dx)] = intbool{ true };
+            dx = -std::exchange(dy, dx);
+            if (arm && arm % 2 == 0)
+                len -= std::min<std::size_t>(len, 2);
+        }
+        return sz;
+    }
+
+    template<containers::union_find::compress compression, containers::union_find::link linking>
+    std::size_t solve_policy(islands::matrix<bool const *> const &input)
+    {
+        return islands::solve<islands::connectivity::four, containers::basic_tree<compression, linking>>(input);
+    }
+
+    struct policy_t
+    {
+        char const *const txt;
+        std::size_t(*func)(islands::matrix<bool const *> const &);
+    } const policies[]{
+        {"none/index:      ", &solve_policy<containers::union_find::compress::none,
+            containers::union_find::link::by_index>},
+        {"halving/index:   ", &solve_policy<containers::union_find::compress::halving,
+            containers::union_find::link::by_index>},
+        {"splitting/index: ", &solve_policy<containers::union_find::compress::splitting,
+            containers::union_find::link::by_index>},
+        {"none/size:       ", &solve_policy<containers::union_find::compress::none,
+            containers::union_find::link::by_size>},
+        {"halving/size:    ", &solve_policy<containers::union_find::compress::halving,
+            containers::union_find::link::by_size>},
+        {"halving/rank:    ", &solve_policy<containers::union_find::compress::halving,
+            containers::union_find::link::by_rank>},
+    };
+
+    //Packs first, so timings include the conversion
+    std::size_t solve_packed(islands::matrix<bool const *> const &input)
+    {
+        auto const packed{ islands::pack(input) };
+        return islands::solve(islands::packed_matrix<islands::packed_word const *>{
+            packed.width, packed.height, packed.stride, packed.data.get()
+        });
+    }
+
+    //Small grain, so even the small fuzzed grids get split across tasks
+    template<islands::connectivity conn = islands::connectivity::four>
+    std::size_t solve2_parallel(islands::matrix<bool const *> const &input)
+    {
+        static tasks::pool workers;
+        return islands::solve2<conn>(input, workers, 16);
+    }
+
+    //Copies the grid out column-major, so solve has to take its transposed fast path
+    template<islands::connectivity conn = islands::connectivity::four>
+    std::size_t solve_column_major(islands::matrix<bool const *> const &input)
+    {
+        auto const &wt{ input.coords.width().len }, &ht{ input.coords.height().len };
+        auto const cells{ std::make_unique<bool[]>(wt * ht) };
+        for (std::size_t index{ 0 }; index < ht; ++index)
+            for (std::size_t jndex{ 0 }; jndex < wt; ++jndex)
+                cells[jndex * ht + index] = input.data[input.coords[{ jndex, index }].to_scalar()];
+        return islands::solve<conn>({ lin_alg3::slice<2>{ 0, {
+            { wt, static_cast<std::ptrdiff_t>(ht) }, { ht, 1 } } }, cells.get() });
+    }
+
+    //Batches the grid with its inverse and an empty grid, all of one shape, then with its
+    //transpose, which makes a mixed batch unless the grid is square; one arena serves every call on a thread
+    std::size_t solve_batched(islands::matrix<bool const *> const &input)
+    {
+        thread_local islands::batch_arena arena;
+        auto const &wt{ input.coords.width() }, &ht{ input.coords.height() };
+        auto const sz{ wt.len * ht.len };
+        auto const inverse{ std::make_unique<bool[]>(sz) }, empty{ std::make_unique<bool[]>(sz) };
+        for (std::size_t index{ 0 }; index < ht.len; ++index)
+            for (std::size_t jndex{ 0 }; jndex < wt.len; ++jndex)
+                inverse[index * wt.len + jndex] = !input.data[input.coords[{ jndex, index }].to_scalar()];
+        islands::matrix<bool const *> const others[]{
+            { islands::matrix_slice(wt.len, ht.len), inverse.get() },
+            { islands::matrix_slice(wt.len, ht.len), empty.get() },
+            { lin_alg3::slice<2>{ input.coords.start, { ht, wt } }, input.data }
+        }, &inverted{ others[0] }, &blank{ others[1] }, &transposed{ others[2] };
+        //More than batch_group, so the last group is partly full
+        islands::matrix<bool const *> const uniform[]{
+            input, inverted, blank, input, inverted, blank, inverted, input, blank, inverted
+        }, mixed[]{ input, transposed, inverted };
+        std::size_t counts[std::size(uniform) + std::size(mixed)];
+        islands::solve_batch(uniform, counts, arena);
+        islands::solve_batch(mixed, std::span{ counts }.subspan(std::size(uniform)), arena);
+        std::size_t index{ 0 };
+        for (auto const grids : { std::span<islands::matrix<bool const *> const>{ uniform },
+            std::span<islands::matrix<bool const *> const>{ mixed } })
+            for (auto const &grid : grids)
+                if (counts[index++] != islands::solve4(grid))
+                    return -1;
+        return counts[0];
+    }
+
+    //Tiny tiles, so even the small fuzzed grids get merged both ways, across odd seams too
+    template<islands::connectivity conn = islands::connectivity::four>
+    std::size_t solve2_tiled_small(islands::matrix<bool const *> const &input)
+    {
+        return islands::solve2_tiled<conn>(input, 3);
+    }
+
+    //count_islands under random thresholds (round-tripped through their text format), so any grid
+    //can land on any engine
+    template<islands::connectivity conn = islands::connectivity::four>
+    std::size_t solve_dispatched(islands::matrix<bool const *> const &input)
+    {
+        std::uniform_real_distribution<double> fraction(0, 1);
+        std::uniform_int_distribution<std::size_t> cells(0, 2 * input.coords.width().len * input.coords.height().len);
+        auto const [sparse, dense] { std::minmax({ fraction(engine), fraction(engine) }) };
+        islands::dispatch_thresholds const limits{ .tile_cells{ cells(engine) }, .sparse{ sparse },
+            .dense{ dense }, .runs{ fraction(engine) }, .sample_cells{ cells(engine) } };
+        std::stringstream buffer;
+        limits.write(buffer);
+        return islands::count_islands<conn>(input, islands::dispatch_thresholds::read(buffer));
+    }
+
+    //Solves the grid out of core, as it were: bands of a few rows, each cut in two at a random column,
+    //summarized separately and round-tripped through the binary format before being merged
+    template<islands::connectivity conn = islands::connectivity::four>
+    std::size_t solve_summarized(islands::matrix<bool const *> const &input)
+    {
+        auto const &wt{ input.coords.width() }, &ht{ input.coords.height() };
+        std::uniform_int_distribution<std::size_t> rows(1, 4), cut(0, wt.len);
+        auto const block{ [&](std::size_t x, std::size_t y, std::size_t width, std::size_t height)
+            {
+                std::stringstream buffer;
+                auto const start{ input.coords.start + static_cast<std::ptrdiff_t>(x) * wt.stride +
+                    static_cast<std::ptrdiff_t>(y) * ht.stride };
+                islands::summarize<conn>({ lin_alg3::slice<2>{ start,
+                    { { width, wt.stride }, { height, ht.stride } } }, input.data }, x, y, wt.len, 2).write(buffer);
+                return islands::summary::read(buffer);
+            } };
+        islands::summary total;
+        for (std::size_t y{ 0 }; y < ht.len; )
+        {
+            auto const height{ std::min(rows(engine), ht.len - y) }, split{ cut(engine) };
+            total = islands::merge(std::move(total), islands::merge(block(0, y, split, height),
+                block(split, y, wt.len - split, height)));
+            y += height;
+        }
+        return total.count();
+    }
+
+    //Labels the grid, then checks the labels against the count: water is 0, every land cell shares
+    //its label with its earlier neighbors, and labels come 1, 2, ... in order of first appearance
+    template<islands::connectivity conn = islands::connectivity::four>
+    std::size_t solve_labeled(islands::matrix<bool const *> const &input)
+    {
+        auto const &wt{ input.coords.width().len }, &ht{ input.coords.height().len };
+        std::vector<std::uint32_t> labels(wt * ht);
+        auto const count{ islands::label<conn>(input, std::span{ labels }) };
+        std::uint32_t seen{ 0 };
+        for (std::size_t index{ 0 }; index < ht; ++index)
+            for (std::size_t jndex{ 0 }; jndex < wt; ++jndex)
+            {
+                auto const here{ labels[index * wt + jndex] };
+                if (input.data[input.coords[{ jndex, index }].to_scalar()] != (0 != here) || here > seen + 1)
+                    return -1;
+                seen = std::max(seen, here);
+                if (!here)
+                    continue;
+                //Unsigned wraparound takes care of the left and top edges
+                auto const touches{ [&](std::size_t x, std::size_t y)
+                    { return x >= wt || y >= ht || !labels[y * wt + x] || here == labels[y * wt + x]; } };
+                auto ok{ touches(jndex - 1, index) && touches(jndex, index - 1) };
+                if constexpr (islands::connectivity::eight == conn)
+                    ok = ok && touches(jndex - 1, index - 1) && touches(jndex + 1, index - 1);
+                else if constexpr (islands::connectivity::hex == conn)
+                    ok = ok && touches(index % 2 ? jndex + 1 : jndex - 1, index - 1);
+                if (!ok)
+                    return -1;
+            }
+        return seen == count ? count : -1;
+    }
+
+    //Recycles ids after every row, so the garbage collection gets exercised as hard as possible
+    std::size_t solve_streamed(islands::matrix<bool const *> const &input)
+    {
+        auto const &wt{ input.coords.width() }, &ht{ input.coords.height() };
+        islands::stream sweep(wt.len, 0);
+        for (std::size_t index{ 0 }; index < ht.len; ++index)
+            sweep.push({ lin_alg3::slice<>(input.coords.start + index * ht.stride, { wt }), input.data });
+        return sweep.count();
+    }
+
+    //Raises the land a cell at a time, in random order, checking the live count against solve as it goes
+    std::size_t solve_incremental(islands::matrix<bool const *> const &input)
+    {
+        auto const &wt{ input.coords.width().len }, &ht{ input.coords.height().len };
+        std::vector<std::pair<std::size_t, std::size_t>> land;
+        for (std::size_t index{ 0 }; index < ht; ++index)
+            for (std::size_t jndex{ 0 }; jndex < wt; ++jndex)
+                if (input.data[input.coords[{ jndex, index }].to_scalar()])
+                    land.emplace_back(jndex, index);
+        std::shuffle(begin(land), end(land), engine);
+        islands::incremental rising(wt, ht);
+        //Partial grid, so the halfway count can be checked too
+        auto const partial{ std::make_unique<bool[]>(wt * ht) };
+        for (std::size_t count{ 0 }; count < size(land); ++count)
+        {
+            auto const &[x, y] { land[count] };
+            rising.set(x, y);
+            partial[y * wt + x] = true;
+            if (count + 1 == (size(land) + 1) / 2 &&
+                rising.count() != islands::solve({ islands::matrix_slice(wt, ht), partial.get() }))
+                return -1;
+        }
+        return rising.count();
+    }
+
+    //Checks the per-island records' totals against a direct count over the cells
+    std::size_t solve_records(islands::matrix<bool const *> const &input)
+    {
+        auto const &wt{ input.coords.width().len }, &ht{ input.coords.height().len };
+        auto const cell{ [&](std::size_t x, std::size_t y) {
+            return x < wt && y < ht && input.data[input.coords[{ x, y }].to_scalar()]; } };
+        std::size_t area{ 0 }, perimeter{ 0 }, sum_x{ 0 }, sum_y{ 0 };
+        for (std::size_t index{ 0 }; index < ht; ++index)
+            for (std::size_t jndex{ 0 }; jndex < wt; ++jndex)
+                if (cell(jndex, index))
+                {
+                    ++area;
+                    //Unsigned wraparound takes care of the left and top edges
+                    perimeter += !cell(jndex - 1, index) + !cell(jndex + 1, index) +
+                        !cell(jndex, index - 1) + !cell(jndex, index + 1);
+                    sum_x += jndex;
+                    sum_y += index;
+                }
+        auto const records{ islands::solve_stats(input) };
+        islands::island_stats total;
+        for (auto const &record : records)
+        {
+            if (record.right - record.left > wt || record.bottom - record.top > ht)
+                return -1;
+            total.fold(record);
+        }
+        auto const areas{ islands::solve_stats<islands::island_area>(input) };
+        if (total.area != area || total.perimeter != perimeter ||
+            total.sum_x != sum_x || total.sum_y != sum_y || size(areas) != size(records))
+            return -1;
+        return size(records);
+    }
+
+    //Binary PBM (P4): rows padded to whole bytes, most significant bit first
+    void write_pbm(std::filesystem::path const &path, islands::matrix<bool const *> const &input)
+    {
+        auto const &wt{ input.coords.width().len }, &ht{ input.coords.height().len };
+        std::ofstream dest(path, std::ios::binary);
+        dest << "P4\n# islands test\n" << wt << ' ' << ht << '\n';
+        for (std::size_t index{ 0 }; index < ht; ++index)
+            for (std::size_t jndex{ 0 }; jndex < wt; jndex += 8)
+            {
+                unsigned char byte{ 0 };
+                for (std::size_t bit{ 0 }; bit < 8 && jndex + bit < wt; ++bit)
+                    if (input.data[input.coords[{ jndex + bit, index }].to_scalar()])
+                        byte |= 0x80 >> bit;
+                dest.put(static_cast<char>(byte));
+            }
+    }
+
+    //Writes the grid out as a P4 PBM, then solves it straight out of the mapped file
+    std::size_t solve_mapped_pbm(islands::matrix<bool const *> const &input)
+    {
+        auto const path{ std::filesystem::temp_directory_path() / "islands_test.pbm" };
+        write_pbm(path, input);
+        std::size_t retval;
+        {
+            mapped::pbm const file(path);
+            retval = islands::solve(file.view());
+        }
+        std::filesystem::remove(path);
+        return retval;
+    }
+
+    //Writes the grid out a byte per cell, then runs solve2 on the mapping in place
+    std::size_t solve_mapped_raw(islands::matrix<bool const *> const &input)
+    {
+        auto const &wt{ input.coords.width().len }, &ht{ input.coords.height().len };
+        auto const path{ std::filesystem::temp_directory_path() / "islands_test.raw" };
+        {
+            std::ofstream dest(path, std::ios::binary);
+            for (std::size_t index{ 0 }; index < ht; ++index)
+                for (std::size_t jndex{ 0 }; jndex < wt; ++jndex)
+                    dest.put(input.data[input.coords[{ jndex, index }].to_scalar()]);
+        }
+        std::size_t retval;
+        {
+            mapped::raw_bytes const file(path, wt, ht);
+            retval = islands::solve2(file.view());
+        }
+        std::filesystem::remove(path);
+        return retval;
+    }
+
+    //Labels the grid straight into a mapped file, which has to match labeling into memory
+    std::size_t solve_mapped_labels(islands::matrix<bool const *> const &input)
+    {
+        auto const &wt{ input.coords.width().len }, &ht{ input.coords.height().len };
+        auto const path{ std::filesystem::temp_directory_path() / "islands_test.labels" };
+        std::vector<std::uint32_t> expected(wt * ht);
+        auto retval{ islands::label(input, std::span{ expected }) };
+        {
+            mapped::label_map<> const file(path, wt, ht);
+            if (islands::label(input, file.labels()) != retval ||
+                !std::ranges::equal(file.labels(), expected))
+                retval = -1;
+        }
+        std::filesystem::remove(path);
+        return retval;
+    }
+
+    //The grid as a single layer of a voxel volume, so the N-D solve has to match the 2D engines
+    std::size_t solve_volume(islands::matrix<bool const *> const &input)
+    {
+        auto const &wt{ input.coords.width() }, &ht{ input.coords.height() };
+        return islands::solve(islands::matrix<bool const *, 3>{
+            lin_alg3::slice<3>{ input.coords.start, { wt, ht, { 1, 0 } } }, input.data });
+    }
+
+    //Reference for solve on volumes: plain flood fill over a width x height x depth grid, x fastest
+    std::size_t flood_volume(std::size_t const (&lens)[3], bool const *cells)
+    {
+        std::size_t const steps[]{ 1, lens[0], lens[0] * lens[1] }, sz{ steps[2] * lens[2] };
+        std::vector<char> seen(sz);
+        std::vector<std::size_t> pending;
+        std::size_t retval{ 0 };
+        for (std::size_t start{ 0 }; start < sz; ++start)
+        {
+            if (!cells[start] || seen[start])
+                continue;
+            ++retval;
+            seen[start] = true;
+            pending.push_back(start);
+            while (!pending.empty())
+            {
+                auto const cell{ pending.back() };
+                pending.pop_back();
+                for (std::size_t axis{ 0 }; axis < 3; ++axis)
+                {
+                    auto const coord{ cell / steps[axis] % lens[axis] };
+                    for (auto const next : { coord ? cell - steps[axis] : cell,
+                        coord + 1 < lens[axis] ? cell + steps[axis] : cell })
+                        if (cells[next] && !seen[next])
+                        {
+                            seen[next] = true;
+                            pending.push_back(next);
+                        }
+                }
+            }
+        }
+        return retval;
+    }
+
+    //Random volumes, solved along every ordering of their axes, against flood_volume
+    bool check_volumes(std::size_t trials)
+    {
+        std::uniform_int_distribution<std::size_t> side(1, 12);
+        for (std::size_t trial{ 0 }; trial < trials; ++trial)
+        {
+            std::size_t const lens[]{ side(engine), side(engine), side(engine) };
+            auto const sz{ lens[0] * lens[1] * lens[2] };
+            auto const cells{ std::make_unique<bool[]>(sz) };
+            std::generate_n(cells.get(), sz, [] { return 1 == coin_flip(engine); });
+            auto const expected{ flood_volume(lens, cells.get()) };
+            std::ptrdiff_t const steps[]{ 1, static_cast<std::ptrdiff_t>(lens[0]),
+                static_cast<std::ptrdiff_t>(lens[0] * lens[1]) };
+            std::size_t order[]{ 0, 1, 2 };
+            do
+            {
+                lin_alg3::slice<3> coords{ 0, {
+                    { lens[order[0]], steps[order[0]] },
+                    { lens[order[1]], steps[order[1]] },
+                    { lens[order[2]], steps[order[2]] } } };
+                auto const value{ islands::solve(islands::matrix<bool const *, 3>{ coords, cells.get() }) };
+                if (value != expected)
+                {
+                    std::cout << "ERROR! Expected " << expected << " islands in " <<
+                        lens[0] << "x" << lens[1] << "x" << lens[2] << " volume, got " << value <<
+                        " sweeping axis " << order[2] << std::endl;
+                    return true;
+                }
+            } while (std::next_permutation(std::begin(order), std::end(order)));
+        }
+        return false;
+    }
+
+    //Random grids, split across worker processes (sometimes more of them than rows), against solve
+    //Kept out of the families, since forking for every fuzzed grid would swamp the fuzzing
+    bool check_shards(std::size_t trials)
+    {
+        std::uniform_int_distribution<std::size_t> side(1, 40), shards(1, 6);
+        for (std::size_t trial{ 0 }; trial < trials; ++trial)
+        {
+            auto const wt{ side(engine) }, ht{ side(engine) }, count{ shards(engine) };
+            auto const cells{ std::make_unique<bool[]>(wt * ht) };
+            std::generate_n(cells.get(), wt * ht, [] { return 1 == coin_flip(engine); });
+            islands::matrix<bool const *> const input{ islands::matrix_slice(wt, ht), cells.get() };
+            std::size_t const expected[]{ islands::solve(input), islands::solve<islands::connectivity::eight>(input),
+                islands::solve<islands::connectivity::hex>(input) }, values[]{ sharded::solve(input, count),
+                sharded::solve<islands::connectivity::eight>(input, count),
+                sharded::solve<islands::connectivity::hex>(input, count) };
+            for (std::size_t family{ 0 }; family < std::size(expected); ++family)
+                if (values[family] != expected[family])
+                {
+                    std::cout << "ERROR! Expected " << expected[family] << " islands in " << wt << "x" << ht <<
+                        " grid, got " << values[family] << " from " << count << " shards" << std::endl;
+                    return true;
+                }
+        }
+        return false;
+    }
+
+    //Random orders of random grids, with every count along the sweep checked against solve on the cells
+    //occupied so far, plus the curve's ends
+    bool check_percolation(std::size_t trials)
+    {
+        std::uniform_int_distribution<std::size_t> side(1, 12);
+        for (std::size_t trial{ 0 }; trial < trials; ++trial)
+        {
+            auto const wt{ side(engine) }, ht{ side(engine) };
+            std::vector<std::size_t> order(wt * ht);
+            std::iota(begin(order), end(order), std::size_t{ 0 });
+            std::shuffle(begin(order), end(order), engine);
+            std::vector<std::size_t> const sweeps[]{ islands::percolation_sweep(wt, ht, order),
+                islands::percolation_sweep<islands::connectivity::eight>(wt, ht, order),
+                islands::percolation_sweep<islands::connectivity::hex>(wt, ht, order) };
+            auto const cells{ std::make_unique<bool[]>(wt * ht) };
+            islands::matrix<bool const *> const input{ islands::matrix_slice(wt, ht), cells.get() };
+            for (std::size_t land{ 0 }; land <= size(order); ++land)
+            {
+                if (land)
+                    cells[order[land - 1]] = true;
+                std::size_t const expected[]{ islands::solve(input), islands::solve<islands::connectivity::eight>(input),
+                    islands::solve<islands::connectivity::hex>(input) };
+                for (std::size_t family{ 0 }; family < std::size(expected); ++family)
+                    if (sweeps[family][land] != expected[family])
+                    {
+                        std::cout << "ERROR! Expected " << expected[family] << " islands in " << wt << "x" << ht <<
+                            " grid after " << land << " cells, got " << sweeps[family][land] << std::endl;
+                        return true;
+                    }
+            }
+            if (0 != islands::percolation_curve(sweeps[0], 0) || 1 != islands::percolation_curve(sweeps[0], 1))
+            {
+                std::cout << "ERROR! Percolation curve doesn't start at 0 and end at 1 island" << std::endl;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //Each generator should be reproducible from its seed and land near the density asked of it
+    bool check_generators(void)
+    {
+        constexpr std::size_t const wt{ 256 }, ht{ 256 }, sz{ wt * ht };
+        auto const cells{ std::make_unique<bool[]>(sz) }, again{ std::make_unique<bool[]>(sz) };
+        auto const fill{ [](bool *dest, std::size_t pattern, double p)
+            {
+                generate::engine rng;
+                std::span<bool> const grid{ dest, sz };
+                if (0 == pattern)
+                    generate::bernoulli(grid, p, rng);
+                else if (1 == pattern)
+                    generate::clustered(grid, wt, p, 4, rng);
+                else
+                    generate::correlated(grid, wt, p, 4, rng);
+            } };
+        char const *const names[]{ "bernoulli", "clustered", "correlated" };
+        for (std::size_t pattern{ 0 }; pattern < std::size(names); ++pattern)
+            for (auto const p : { 0., 0.3, 0.5, 0.7, 1. })
+            {
+                fill(cells.get(), pattern, p);
+                fill(again.get(), pattern, p);
+                auto const density{ static_cast<double>(std::count(cells.get(), cells.get() + sz, true)) / sz };
+                if (!std::equal(cells.get(), cells.get() + sz, again.get()) || std::abs(density - p) > 0.02)
+                {
+                    std::cout << "ERROR! " << names[pattern] << " grid at p = " << p << " came out with density " <<
+                        density << std::endl;
+                    return true;
+                }
+            }
+        generate::engine rng;
+        for (auto const p : { 0., 0.3, 0.5, 0.7, 1. })
+        {
+            auto const packed{ generate::bernoulli_packed(1000, 100, p, rng) };
+            std::size_t land{ 0 };
+            for (std::size_t index{ 0 }; index < packed.height; ++index)
+                for (std::size_t word{ 0 }; word < static_cast<std::size_t>(packed.stride); ++word)
+                    land += std::popcount(packed.data[index * packed.stride + word]);
+            if (std::abs(static_cast<double>(land) / (packed.width * packed.height) - p) > 0.02)
+            {
+                std::cout << "ERROR! Packed grid at p = " << p << " came out with " << land << " land" << std::endl;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //Every engine in a family gets checked against every other
+    struct solver_t
+    {
+        char const *const txt;
+        std::size_t(*func)(islands::matrix<bool const *> const &);
+    } const solvers[]{
+        {"V1", &islands::solve},
+        {"VC", &solve_column_major},
+        {"V2", &islands::solve2},
+        {"VT", &solve2_parallel},
+        {"V2T", &solve2_tiled_small},
+        {"VO", &solve_summarized},
+        {"VL", &solve_labeled},
+        {"V3", &islands::solve3},
+        {"V4", &islands::solve4},
+        {"VS", &solve_streamed},
+        {"VI", &solve_incremental},
+        {"VR", &solve_records},
+        {"VP", &solve_packed},
+        {"VN", &solve_volume},
+        {"VB", &solve_batched},
+        {"VA", &solve_dispatched},
+    }, solvers8[]{
+        {"V1-8", &islands::solve<islands::connectivity::eight>},
+        {"VC-8", &solve_column_major<islands::connectivity::eight>},
+        {"V2-8", &islands::solve2<islands::connectivity::eight>},
+        {"VT-8", &solve2_parallel<islands::connectivity::eight>},
+        {"V2T-8", &solve2_tiled_small<islands::connectivity::eight>},
+        {"VO-8", &solve_summarized<islands::connectivity::eight>},
+        {"VL-8", &solve_labeled<islands::connectivity::eight>},
+        {"V3-8", &islands::solve3<islands::connectivity::eight>},
+        {"VA-8", &solve_dispatched<islands::connectivity::eight>},
+    }, solvers_hex[]{
+        {"V1-H", &islands::solve<islands::connectivity::hex>},
+        {"VC-H", &solve_column_major<islands::connectivity::hex>},
+        {"V2-H", &islands::solve2<islands::connectivity::hex>},
+        {"VT-H", &solve2_parallel<islands::connectivity::hex>},
+        {"V2T-H", &solve2_tiled_small<islands::connectivity::hex>},
+        {"VO-H", &solve_summarized<islands::connectivity::hex>},
+        {"VL-H", &solve_labeled<islands::connectivity::hex>},
+        {"V3-H", &islands::solve3<islands::connectivity::hex>},
+        {"VA-H", &solve_dispatched<islands::connectivity::hex>},
+    };
+    std::span<solver_t const> const families[]{ solvers, solvers8, solvers_hex };
+
     template<bool always_print = true>
     bool analyze(islands::matrix<std::vector<intbool>> &giant, std::size_t const sz)
     {
-        for (std::size_t index{ 0 }; index < sz; ++index)
-            giant.data[index] = intbool(coin_flip(engine));
-        std::size_t value, value2, value3;
+        generate::bernoulli(std::span{ reinterpret_cast<bool *>(giant.data.data()), sz }, 0.499, grid_engine);
+        std::size_t values[std::size(families)][std::size(solvers)];
+        auto retval{ false };
+        for (std::size_t family{ 0 }; family < std::size(families); ++family)
         {
-            struct loop_iter_t
-            {
-                char const *const txt;
-                size_t(*func)(islands::matrix<bool const *> const &);
-                std::size_t &dest;
-            } iters[]{
-                {"V1: ", &islands::solve, value},
-                {"V2: ", &islands::solve2, value2},
-                {"V3: ", &islands::solve3, value3},
-            };
-            for (auto const &iter : iters)
+            auto const &members{ families[family] };
+            assert(size(members) <= std::size(solvers));
+            auto dest{ values[family] };
+            for (auto const &solver : members)
             {
                 //Can't use if constexpr b/c that creates a new scope, 
                 //but a pair of reference/ptrs gets optimized out
                 std::conditional_t<always_print,
                     timer,
                     std::pair<std::ostream&, char const*const> const> 
-                    _guard(std::cout, iter.txt);
-                iter.dest = (*iter.func)({ giant.coords, reinterpret_cast<bool*>(giant.data.data()) });
+                    _guard(std::cout, solver.txt);
+                *dest++ = (*solver.func)({ giant.coords, reinterpret_cast<bool*>(giant.data.data()) });
             }
+            retval |= std::adjacent_find(values[family], dest, std::not_equal_to<>{}) != dest;
         }
-        auto retval{ value != value2 || value2 != value3 };
         if (always_print || retval)
         {
             if (giant.coords.height().len < 100 && giant.coords.width().len < 100)
@@ -108,13 +690,188 @@ namespace test
                     std::cout);
                 std::cout << std::endl;
             }
-            std::cout <<
-                "(V1) " << value << " (V2) " << value2 << " (V3) " << value3 << 
-                " islands in giant matrix." << std::endl;
+            for (std::size_t family{ 0 }; family < std::size(families); ++family)
+            {
+                for (std::size_t index{ 0 }; index < size(families[family]); ++index)
+                    std::cout << "(" << families[family][index].txt << ") " << values[family][index] << " ";
+                std::cout << "islands in giant matrix." << std::endl;
+            }
         }
         return retval;
     }
 
+    //The randomized engines (cuts, insertion orders, thresholds) all draw from engine, so reseeding it
+    //before a run makes the run repeatable
+    void reseed(std::uint64_t salt)
+    {
+        engine.seed(static_cast<std::default_random_engine::result_type>(salt ^ salt >> 32));
+    }
+
+    //Whether every engine in each family agrees with the family's first; one that throws doesn't
+    [[nodiscard]] bool agrees(islands::matrix<bool const *> const &input, std::uint64_t salt)
+    {
+        reseed(salt);
+        try
+        {
+            for (auto const &members : families)
+            {
+                auto const first{ (*members.front().func)(input) };
+                for (auto const &solver : members.subspan(1))
+                    if ((*solver.func)(input) != first)
+                        return false;
+            }
+            return true;
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    //The grid, if small enough to read, then what each engine makes of it, run as agrees runs them
+    void report(islands::matrix<bool const *> const &input, std::uint64_t salt, std::ostream &dest)
+    {
+        reseed(salt);
+        if (input.coords.height().len < 100 && input.coords.width().len < 100)
+        {
+            test::print_matrix(input, dest);
+            dest << std::endl;
+        }
+        for (auto const &members : families)
+        {
+            for (auto const &solver : members)
+            {
+                dest << "(" << solver.txt << ") ";
+                try
+                {
+                    dest << (*solver.func)(input) << " ";
+                }
+                catch (...)
+                {
+                    dest << "threw ";
+                }
+            }
+            dest << "islands in giant matrix." << std::endl;
+        }
+    }
+
+    //Whittles a grid (wt wide, row-major) the families disagree on down for as long as they keep
+    //disagreeing: whole rows and columns first, then land cells one at a time, until no single
+    //deletion still fails; every try runs with the same salt, so the target holds still
+    void minimize(std::size_t &wt, std::size_t &ht, std::vector<char> &cells, std::vector<char> &trial,
+        std::uint64_t salt)
+    {
+        constexpr auto const none{ std::numeric_limits<std::size_t>::max() };
+        //The grid less one row or column, or neither, into trial
+        auto const without{ [&](std::size_t row, std::size_t column)
+            {
+                trial.clear();
+                for (std::size_t index{ 0 }; index < ht; ++index)
+                    for (std::size_t jndex{ 0 }; index != row && jndex < wt; ++jndex)
+                        if (jndex != column)
+                            trial.push_back(cells[index * wt + jndex]);
+            } };
+        auto const fails{ [&trial, salt](std::size_t width, std::size_t height)
+            {
+                return !agrees({ islands::matrix_slice(width, height), reinterpret_cast<bool const *>(trial.data()) },
+                    salt);
+            } };
+        for (auto shrunk{ true }; shrunk; )
+        {
+            shrunk = false;
+            for (std::size_t row{ 0 }; ht > 1 && row < ht; )
+                if (without(row, none); fails(wt, ht - 1))
+                    cells.swap(trial), --ht, shrunk = true;
+                else
+                    ++row;
+            for (std::size_t column{ 0 }; wt > 1 && column < wt; )
+                if (without(none, column); fails(wt - 1, ht))
+                    cells.swap(trial), --wt, shrunk = true;
+                else
+                    ++column;
+            for (std::size_t index{ 0 }; index < wt * ht; ++index)
+                if (cells[index])
+                {
+                    without(none, none);
+                    trial[index] = false;
+                    if (fails(wt, ht))
+                        cells.swap(trial), shrunk = true;
+                }
+        }
+    }
+
+    //Fuzzes every family on grids_per_shape random grids of each (width, height), dealt out a shape at
+    //a time to threads workers, each drawing from its own engine (seed plus its index) into its own
+    //buffers, along with a salt per grid for the randomized engines; the first mismatch stops them
+    //all, and is minimized, reported, and saved under dir as a PBM named for its salt, for main to
+    //replay. True if there was one
+    bool fuzz(std::span<std::pair<std::size_t, std::size_t> const> shapes, std::size_t grids_per_shape,
+        std::size_t threads, std::uint64_t seed, std::filesystem::path const &dir)
+    {
+        std::atomic<std::size_t> next{ 0 };
+        std::atomic<bool> failed{ false };
+        {
+            std::vector<std::jthread> workers;
+            for (std::size_t worker{ 0 }; worker < std::max<std::size_t>(threads, 1); ++worker)
+                workers.emplace_back([&, worker]
+                    {
+                        generate::engine rng(seed + worker);
+                        std::vector<char> cells, trial;
+                        for (std::size_t shape; !failed && (shape = next++) < size(shapes); )
+                        {
+                            auto [wt, ht] { shapes[shape] };
+                            cells.resize(wt * ht);
+                            for (std::size_t count{ 0 }; count < grids_per_shape && !failed; ++count)
+                            {
+                                generate::bernoulli(std::span{ reinterpret_cast<bool *>(cells.data()), size(cells) },
+                                    0.499, rng);
+                                auto const salt{ rng() };
+                                if (agrees({ islands::matrix_slice(wt, ht), reinterpret_cast<bool const *>(cells.data()) },
+                                    salt))
+                                    continue;
+                                //Only the first mismatch gets minimized; the rest just stop
+                                if (failed.exchange(true))
+                                    return;
+                                minimize(wt, ht, cells, trial, salt);
+                                islands::matrix<bool const *> const input{
+                                    islands::matrix_slice(wt, ht), reinterpret_cast<bool const *>(cells.data())
+                                };
+                                std::error_code error;
+                                std::filesystem::create_directories(dir, error);
+                                auto const path{ dir / ("mismatch-" + std::to_string(salt) + ".pbm") };
+                                write_pbm(path, input);
+                                std::cout << "ERROR! Engines disagree; minimized to " << wt << "x" << ht <<
+                                    ", saved as " << path.string() << std::endl;
+                                report(input, salt, std::cout);
+                                return;
+                            }
+                        }
+                    });
+        }
+        return failed;
+    }
+
+    //Reruns every family on a grid the fuzzer saved, with the salt its name carries (or a fixed one,
+    //for any other PBM); true if they still disagree
+    bool replay(std::filesystem::path const &path)
+    {
+        auto const stem{ path.stem().string() };
+        auto const salt{ stem.starts_with("mismatch-") ? std::stoull(stem.substr(9)) : generate::default_seed };
+        mapped::pbm const file(path);
+        auto const packed{ file.view() };
+        std::vector<char> cells(packed.width * packed.height);
+        for (std::size_t index{ 0 }; index < packed.height; ++index)
+            for (std::size_t jndex{ 0 }; jndex < packed.width; ++jndex)
+                cells[index * packed.width + jndex] =
+                    packed.data[index * static_cast<std::size_t>(packed.stride) + jndex / 8] >> (7 - jndex % 8) & 1;
+        islands::matrix<bool const *> const input{
+            islands::matrix_slice(packed.width, packed.height), reinterpret_cast<bool const *>(cells.data())
+        };
+        std::cout << path.string() << ":" << std::endl;
+        report(input, salt, std::cout);
+        return !agrees(input, salt);
+    }
+
     namespace _internal
     {
         template<std::size_t count>
@@ -180,7 +937,12 @@ namespace test
                 auto const stop{ cend(coords.indices) };
                 decltype(loc) prev;
                 while ((prev = loc++) != stop)
-                    size *= (loc->stride = prev->len);
+                {
+                    size *= prev->len;
+                    //The outermost axis has no successor to hand its stride to
+                    if (loc != stop)
+                        loc->stride = size;
+                }
             }
             this->data = std::make_unique<bool[]>(size);
             copy_data(data, this->coords.indices + dim - 1, this->data.get());
@@ -325,36 +1087,148 @@ namespace test
             {0,0,1,1,0,1,1,1,0,0,1,1,1,1,1,1}
         }
     };
+    //Expected counts under four-, eight- and hex-connectivity, in the order of families
+    static struct stencil_case_t
+    {
+        matrix_view input;
+        std::size_t expected[std::size(families)];
+    } stencil_cases[]{
+        { matrix_view{
+            {1, 0},
+            {0, 1}
+        }, {2, 1, 2} },
+        { matrix_view{
+            {0, 1},
+            {1, 0}
+        }, {2, 1, 1} },
+        { matrix_view{
+            {1, 0, 1},
+            {0, 1, 0},
+            {1, 0, 1}
+        }, {5, 1, 3} },
+        { matrix_view{
+            {1, 1, 0, 1},
+            {0, 0, 1, 0},
+            {1, 0, 0, 1},
+            {0, 1, 1, 0}
+        }, {6, 1, 3} },
+    };
 }
 
-int _cdecl main()
+int _cdecl main(int argc, char *argv[])
 {
     using namespace test;
+    //Given grids the fuzzer saved, just replay those
+    if (argc > 1)
+    {
+        auto retval{ 0 };
+        for (int index{ 1 }; index < argc; ++index)
+            try
+            {
+                if (replay(argv[index]))
+                    retval = 1;
+            }
+            catch (std::exception const &error)
+            {
+                std::cout << argv[index] << ": " << error.what() << std::endl;
+                retval = 1;
+            }
+        return retval;
+    }
+    //Before anything starts a thread (solve2_parallel's pool, the fuzzer's workers): a forked child
+    //only gets the forking thread, so a lock another thread held would never be released
+    if (!check_shards(64))
+        std::cout << "Shards: no errors found." << std::endl;
     for (auto const &test_case : test_cases)
     {
         //Run first for exception-safety
         auto const &input{ test_case.first };
         islands::matrix<bool const *> const converted{ input.coords, input.data.get() };
-        auto const value{ islands::solve(converted) },
-            value2{ islands::solve2(converted) },
-            value3{ islands::solve3(converted) };
+        std::cout << "Expected " << std::setw(2) << test_case.second << ", got";
+        for (auto const &solver : solvers)
+            std::cout << " (" << solver.txt << ") " << std::setw(2) << (*solver.func)(converted);
+        //Too slow for the fuzzer, b/c of the trip through the filesystem
         std::cout <<
-            "Expected " << std::setw(2) << test_case.second << ", got "
-            "(V1) " << std::setw(2) << value << " "
-            "(V2) " << std::setw(2) << value2 << " "
-            "(V3) " << std::setw(3) << value3 << std::endl;
+            " (PBM) " << std::setw(2) << solve_mapped_pbm(converted) <<
+            " (RAW) " << std::setw(2) << solve_mapped_raw(converted) <<
+            " (LBL) " << std::setw(2) << solve_mapped_labels(converted) << std::endl;
+    }
+    for (auto const &[input, expected] : stencil_cases)
+    {
+        islands::matrix<bool const *> const converted{ input.coords, input.data.get() };
+        for (std::size_t family{ 0 }; family < std::size(families); ++family)
+        {
+            std::cout << "Expected " << std::setw(2) << expected[family] << ", got";
+            for (auto const &solver : families[family])
+                std::cout << " (" << solver.txt << ") " << std::setw(2) << (*solver.func)(converted);
+            std::cout << std::endl;
+        }
+    }
+    if (!check_volumes(256))
+        std::cout << "Volumes: no errors found." << std::endl;
+    if (!check_percolation(64))
+        std::cout << "Percolation: no errors found." << std::endl;
+    if (!check_generators())
+        std::cout << "Generators: no errors found." << std::endl;
+    if constexpr (stats::enabled)
+    {
+        //What the union-find and merges did on the first test case, serially and on the pool
+        auto const &[input, expected] { test_cases[0] };
+        islands::matrix<bool const *> const converted{ input.coords, input.data.get() };
+        (void)stats::collect();
+        (void)islands::solve2(converted);
+        std::cout << "solve2 stats: ";
+        stats::collect().write_json(std::cout);
+        (void)solve2_parallel(converted);
+        std::cout << std::endl << "Parallel solve2 stats: ";
+        stats::collect().write_json(std::cout);
+        std::cout << std::endl;
     }
     islands::matrix<std::vector<intbool>> giant;
-    std::size_t wt, ht;
+    {
+        struct adversary_t
+        {
+            char const *const txt;
+            std::size_t(*make)(std::size_t, islands::matrix<std::vector<intbool>> &);
+            std::size_t size;
+        } const adversaries[]{
+            {"comb", &make_comb, 4096},
+            {"spiral", &make_spiral, 4096},
+        };
+        for (auto const &adversary : adversaries)
+        {
+            (*adversary.make)(adversary.size, giant);
+            std::cout << "Adversarial " << adversary.txt << ":" << std::endl;
+            for (auto const &policy : policies)
+            {
+                std::size_t value;
+                {
+                    timer _guard(std::cout, policy.txt);
+                    value = (*policy.func)({ giant.coords, reinterpret_cast<bool *>(giant.data.data()) });
+                }
+                if (1 != value)
+                    std::cout << "ERROR! Expected 1 island, got " << value << std::endl;
+            }
+            //One island spanning millions of cells, so a flood fill that recursed per cell would
+            //overflow its stack here
+            std::size_t value;
+            {
+                timer _guard(std::cout, "flood fill:      ");
+                value = islands::solve3({ giant.coords, reinterpret_cast<bool *>(giant.data.data()) });
+            }
+            if (1 != value)
+                std::cout << "ERROR! Expected 1 island, got " << value << std::endl;
+        }
+    }
 #ifndef GIANT
-    wt = sizing(engine), ht = sizing(engine);
+    std::size_t const wt{ sizing(engine) }, ht{ sizing(engine) };
     auto const sz{ resize_matrix(wt, ht, giant) };
     analyze<>(giant, sz);
 #else
     try
     {
 #ifdef FUZZ_FIXED_SIZE
-        wt = 8, ht = 16;
+        std::size_t const wt{ 8 }, ht{ 16 };
         std::size_t const sz{ resize_matrix(wt, ht, giant) };
         for (std::size_t count{ 0 };;)
         {
@@ -364,16 +1238,17 @@ int _cdecl main()
             std::cout << "Tested " << count << "; no crash yet..." << std::endl;
         }
 #else
+        //Every shape with the same sum of sides at once, spread over every core
+        auto const threads{ std::max(std::thread::hardware_concurrency(), 1u) };
+        auto const failures{ std::filesystem::current_path() / "fuzz_failures" };
+        std::vector<std::pair<std::size_t, std::size_t>> shapes;
         for (std::size_t sum{ 2 }; sum < /*200*/100; ++sum)
         {
-            for (wt = 1; wt < std::min<std::size_t>(sum, 100); ++wt)
-            {
-                ht = sum - wt;
-                auto const sz{ resize_matrix(wt, ht, giant) };
-                for (std::size_t count{ 0 }; count < 1024; ++count)
-                    if (analyze<false>(giant, sz))
-                        return 0;
-            }
+            shapes.clear();
+            for (std::size_t wt{ 1 }; wt < std::min<std::size_t>(sum, 100); ++wt)
+                shapes.emplace_back(wt, sum - wt);
+            if (fuzz(shapes, 1024, threads, grid_engine(), failures))
+                return 0;
             std::cout << "Sum = " << sum << "; no errors found." << std::endl;
         }
 #endif
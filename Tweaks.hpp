@@ -1,9 +1,12 @@
 #pragma once
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <concepts>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 #define CRTP_ACCESS(CRTP_name) \
@@ -12,27 +15,6 @@
 
 namespace utils
 {
-    template<std::bidirectional_iterator Iter>
-    [[nodiscard]] auto invert_injection(Iter start, Iter stop)
-    {
-        auto count{ stop - start };
-        auto rstart{ std::make_reverse_iterator(stop) }, rstop{ std::make_reverse_iterator(start) };
-        typedef std::iter_value_t<Iter> table_t;
-        std::unique_ptr<table_t[]> lookup_table;
-        if(count)
-            lookup_table = std::make_unique_for_overwrite<table_t[]>(*rstart + 1);
-        while(rstop != rstart)
-            lookup_table[*rstart++] = --count;
-        return lookup_table;
-    }
-
-    template<std::random_access_iterator Iter>
-    auto uniquify(Iter start, Iter stop)
-    {
-        std::sort(start, stop);
-        return std::unique(start, stop);
-    }
-
     template<std::ios_base::fmtflags flags>
     class scoped_streamstate final
     {
@@ -69,6 +51,140 @@ namespace test
     };
 }
 
+//Define as 1 to have the union-find and solve2's merges count what they do (see stats::collect)
+//Left at 0, every counter compiles away
+#ifndef ISLANDS_STATS
+#define ISLANDS_STATS 0
+#endif
+
+namespace stats
+{
+    constexpr bool const enabled{ 0 != ISLANDS_STATS };
+
+    struct counters
+    {
+        //trace_root's steps are bucketed by count, the last bucket taking everything longer
+        static constexpr std::size_t const step_buckets{ 16 }, levels{ 64 };
+        std::size_t add_new{ 0 };
+        //Calls made by the solvers, and the unions they led to; coalesce skips the union (and its
+        //root tracing) when handed the same id twice
+        std::size_t coalesce{ 0 }, coalesce_nocheck{ 0 }, unions{ 0 };
+        std::size_t trace_steps[step_buckets]{};
+        //solve2's merges by level, the bit width of the merged band's row count less one, and the
+        //boundary ids left after them
+        std::size_t merges[levels]{}, ids[levels]{};
+        //Merge time includes the normalize inside it
+        std::chrono::nanoseconds normalize{ 0 }, merge{ 0 };
+
+        void record_trace(std::size_t steps) noexcept { ++trace_steps[std::min(steps, step_buckets - 1)]; }
+        counters &operator+=(counters const &other) noexcept
+        {
+            add_new += other.add_new;
+            coalesce += other.coalesce;
+            coalesce_nocheck += other.coalesce_nocheck;
+            unions += other.unions;
+            for (std::size_t index{ 0 }; index < step_buckets; ++index)
+                trace_steps[index] += other.trace_steps[index];
+            for (std::size_t index{ 0 }; index < levels; ++index)
+            {
+                merges[index] += other.merges[index];
+                ids[index] += other.ids[index];
+            }
+            normalize += other.normalize;
+            merge += other.merge;
+            return *this;
+        }
+        //One JSON object; the per-level arrays stop at the last level any merge reached
+        void write_json(std::ostream &dest) const
+        {
+            auto const list{ [&dest](std::size_t const *values, std::size_t count)
+                {
+                    dest << '[';
+                    for (std::size_t index{ 0 }; index < count; ++index)
+                        dest << (index ? ", " : "") << values[index];
+                    dest << ']';
+                } };
+            auto depth{ levels };
+            while (depth && !merges[depth - 1])
+                --depth;
+            dest << "{\"add_new\": " << add_new << ", \"coalesce\": " << coalesce <<
+                ", \"coalesce_nocheck\": " << coalesce_nocheck << ", \"unions\": " << unions <<
+                ", \"trace_steps\": ";
+            list(trace_steps, step_buckets);
+            dest << ", \"merges_per_level\": ";
+            list(merges, depth);
+            dest << ", \"ids_per_level\": ";
+            list(ids, depth);
+            dest << ", \"normalize_ns\": " << normalize.count() << ", \"merge_ns\": " << merge.count() << '}';
+        }
+    };
+
+    namespace _internal
+    {
+        //Every thread's counters, so collect can find those of the pool's workers too
+        struct registry
+        {
+            std::mutex lock;
+            std::vector<counters *> live;
+            counters retired; //Left behind by threads that have exited
+        };
+        [[nodiscard]] registry &everyone(void)
+        {
+            static registry retval;
+            return retval;
+        }
+        struct thread_counters : counters
+        {
+            thread_counters(void)
+            {
+                auto &all{ everyone() };
+                std::lock_guard _guard{ all.lock };
+                all.live.push_back(this);
+            }
+            ~thread_counters(void)
+            {
+                auto &all{ everyone() };
+                std::lock_guard _guard{ all.lock };
+                all.retired += *this;
+                std::erase(all.live, this);
+            }
+        };
+        inline thread_local thread_counters mine;
+    }
+
+    //This thread's counters
+    [[nodiscard]] counters &local(void) noexcept { return _internal::mine; }
+
+    //Every thread's counters since the last collect, which zeroes them
+    //Call between solves, when no other thread is counting
+    [[nodiscard]] counters collect(void)
+    {
+        auto &all{ _internal::everyone() };
+        std::lock_guard _guard{ all.lock };
+        auto retval{ std::exchange(all.retired, {}) };
+        for (auto const each : all.live)
+            retval += std::exchange(*each, {});
+        return retval;
+    }
+
+    //Adds its lifetime to one of this thread's timers; does nothing unless stats are enabled
+    template<bool on = enabled>
+    class stopwatch final
+    {
+        std::chrono::nanoseconds &total;
+        std::chrono::steady_clock::time_point const start{ std::chrono::steady_clock::now() };
+    public:
+        explicit stopwatch(std::chrono::nanoseconds counters::*which) : total{ local().*which } {}
+        ~stopwatch(void) { total += std::chrono::steady_clock::now() - start; }
+    };
+    template<>
+    class stopwatch<false> final
+    {
+    public:
+        explicit constexpr stopwatch(std::chrono::nanoseconds counters::*) noexcept {}
+    };
+}
+
 namespace containers
 {
     template<typename inheritor>
@@ -115,26 +231,52 @@ namespace containers
         }
     };
 
+    namespace union_find
+    {
+        //What trace_root does to the path it walks
+        enum class compress { none, halving, splitting };
+        //Which root survives when two trees coalesce
+        enum class link { by_index, by_size, by_rank };
+    }
+
     typedef std::size_t treenode;
-    class tree : protected std::vector<treenode>
+    template<union_find::compress compression, union_find::link linking>
+    class basic_tree : protected std::vector<treenode>
     {
         static_assert(std::is_same_v<treenode, size_type>);
+        //Size or rank of the tree under each root; unused when linking by index
+        std::vector<treenode> weights;
     public:
         typedef treenode node; //Convenience
-        using vector::size_type;
+        using vector::size_type, vector::size;
         using vector::begin, vector::cbegin, vector::end, vector::cend;
-        explicit tree(size_type sz = 0)
-        {
-            reserve(sz);
-            while (sz--)
-                add_new();
-        }
+        explicit basic_tree(size_type sz = 0) { reset(sz); }
         size_type add_new(void)
         {
+            if constexpr (stats::enabled)
+                ++stats::local().add_new;
             auto insertion{ size() };
             emplace_back(insertion);
+            if constexpr (union_find::link::by_index != linking)
+                weights.emplace_back(union_find::link::by_size == linking);
             return insertion;
         }
+        //Forget every node, but keep the storage for the next round
+        void clear(void) noexcept
+        {
+            vector::clear();
+            weights.clear();
+        }
+        //Start over with sz singleton trees
+        void reset(size_type sz)
+        {
+            clear();
+            reserve(sz);
+            if constexpr (union_find::link::by_index != linking)
+                weights.reserve(sz);
+            while (sz--)
+                add_new();
+        }
         [[nodiscard]] auto count_roots(void) const noexcept
         {
             size_type count{ 0 }, index{ 0 };
@@ -145,22 +287,85 @@ namespace containers
         [[nodiscard]] auto trace_root(treenode k) const //not noexcept: Lakos rule
         {
             assert(k < size());
+            [[maybe_unused]] std::size_t steps{ 0 };
             treenode prev;
-            do prev = std::exchange(k, (*this)[k]);
-            while (k != prev);
+            do
+            {
+                prev = std::exchange(k, (*this)[k]);
+                if constexpr (stats::enabled)
+                    ++steps;
+            } while (k != prev);
+            if constexpr (stats::enabled)
+                stats::local().record_trace(steps - 1);
             return k;
         }
-        void coalesce_nocheck(treenode left, treenode above)
+        //Same, but shortens the path on the way up
+        [[nodiscard]] auto trace_root(treenode k)
+        {
+            using enum union_find::compress;
+            assert(k < size());
+            auto &parent{ static_cast<vector &>(*this) };
+            [[maybe_unused]] std::size_t steps{ 0 };
+            if constexpr (halving == compression)
+                //Point every other node at its grandparent
+                while (k != parent[k])
+                {
+                    k = parent[k] = parent[parent[k]];
+                    if constexpr (stats::enabled)
+                        ++steps;
+                }
+            else if constexpr (splitting == compression)
+                //Point every node at its grandparent
+                while (k != parent[k])
+                {
+                    k = std::exchange(parent[k], parent[parent[k]]);
+                    if constexpr (stats::enabled)
+                        ++steps;
+                }
+            else
+                return std::as_const(*this).trace_root(k);
+            if constexpr (stats::enabled)
+                stats::local().record_trace(steps);
+            return k;
+        }
+    private:
+        void unite(treenode left, treenode above)
         {
             for (auto const key : {&left, &above})
                 *key = trace_root(*key);
-            (*this)[above] = (*this)[left] = std::min(above, left);
+            //Only unions that join two trees count
+            if constexpr (stats::enabled)
+                if (left != above)
+                    ++stats::local().unions;
+            if constexpr (union_find::link::by_index == linking)
+                (*this)[above] = (*this)[left] = std::min(above, left);
+            else if (left != above)
+            {
+                //Hang the lighter tree under the heavier, so paths only grow logarithmically
+                if (weights[left] < weights[above])
+                    std::swap(left, above);
+                (*this)[above] = left;
+                if constexpr (union_find::link::by_size == linking)
+                    weights[left] += weights[above];
+                else if (weights[left] == weights[above])
+                    ++weights[left];
+            }
+        }
+    public:
+        void coalesce_nocheck(treenode left, treenode above)
+        {
+            if constexpr (stats::enabled)
+                ++stats::local().coalesce_nocheck;
+            unite(left, above);
         }
-        void coalesce(tree::node left, tree::node above)
+        void coalesce(treenode left, treenode above)
         {
+            if constexpr (stats::enabled)
+                ++stats::local().coalesce;
             //Tracing roots is expensive; skip it if possible
             if (left != above)
-                coalesce_nocheck(left, above);
+                unite(left, above);
         }
     };
+    typedef basic_tree<union_find::compress::halving, union_find::link::by_size> tree;
 }
\ No newline at end of file